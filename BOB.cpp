@@ -31,7 +31,11 @@
 //BOB source
 #include <bitset>
 #include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sstream>
 #include "BOB.h"
+#include "LogicLayerInterface.h"
 
 using namespace std;
 
@@ -45,7 +49,8 @@ unsigned LINK_CPU_CLK_RATIO;
 unsigned DRAM_CPU_CLK_RATIO;
 unsigned DRAM_CPU_CLK_ADJUSTMENT;
 //uint64_t QEMU_MEMORY_SIZE;
-BOB::BOB() : priorityPort(0),
+BOB::BOB() : priorityRequestLink(0),
+	priorityResponseLink(0),
 	readCounter(0),
 	writeCounter(0),
 	committedWrites(0),
@@ -97,19 +102,15 @@ BOB::BOB() : priorityPort(0),
 	DRAM_CPU_CLK_ADJUSTMENT = tCK / fmod(tCK,CPU_CLK_PERIOD);
 	cout<<"DRAM_CPU_CLK_ADJUSTMENT : "<<DRAM_CPU_CLK_ADJUSTMENT<<endl;
 
-	//Ensure that parameters have been set correclty
-	if(NUM_CHANNELS / CHANNELS_PER_LINK_BUS != NUM_LINK_BUSES)
-	{
-		ERROR("== ERROR - Mismatch in NUM_CHANNELS and NUM_LINK_BUSES");
-		exit(0);
-	}
+	//Work out which channels are on which link bus
+	BuildTopology();
 
 	if(DEBUG_BOB) DEBUG("== Channel-CPU clk ratio : "<<LINK_CPU_CLK_RATIO<<"  DRAM-CPU clk ratio : "<<DRAM_CPU_CLK_RATIO);
 
 	//Make port objects
 	for(unsigned i=0; i<NUM_PORTS; i++)
 	{
-		ports.push_back(Port(i));
+		ports.push_back(Port(i, NUM_LINK_BUSES));
 	}
 
 	//Initialize fields for bookkeeping
@@ -117,23 +118,80 @@ BOB::BOB() : priorityPort(0),
 	inFlightResponseLinkCountdowns = vector<unsigned>(NUM_LINK_BUSES,0);
 
 	inFlightRequestLink = vector<Transaction *> (NUM_LINK_BUSES, (Transaction*)(NULL));
+	coalescedRequests = vector< vector<Transaction *> > (NUM_LINK_BUSES, vector<Transaction *>());
+	requestLinkDecompress = vector< deque< pair<uint64_t, Transaction *> > > (NUM_LINK_BUSES);
+	responseLinkDecompress = vector< deque< pair<uint64_t, Transaction *> > > (NUM_LINK_BUSES);
+
+	compressionSeed = COMPRESSION_RANDOM_SEED;
+	requestPayloadBytes = vector<uint64_t> (NUM_LINK_BUSES,0);
+	requestCompressedBytes = vector<uint64_t> (NUM_LINK_BUSES,0);
+	responsePayloadBytes = vector<uint64_t> (NUM_LINK_BUSES,0);
+	responseCompressedBytes = vector<uint64_t> (NUM_LINK_BUSES,0);
+	compressedPackets = vector<unsigned> (NUM_LINK_BUSES,0);
 	inFlightResponseLink = vector<Transaction *> (NUM_LINK_BUSES, (Transaction*)NULL);
 
-	serDesBufferRequest = vector<Transaction *> (NUM_LINK_BUSES, (Transaction*)NULL);
-	serDesBufferResponse = vector<Transaction *> (NUM_LINK_BUSES, (Transaction*)NULL);
+	serDesBufferRequest = vector< deque<Transaction *> > (NUM_LINK_BUSES, deque<Transaction *>());
+	serDesBufferResponse = vector< deque<Transaction *> > (NUM_LINK_BUSES, deque<Transaction *>());
+
+	serDesRequestOccupancy = vector<uint64_t> (NUM_LINK_BUSES,0);
+	serDesResponseOccupancy = vector<uint64_t> (NUM_LINK_BUSES,0);
+	serDesRequestMax = vector<unsigned> (NUM_LINK_BUSES,0);
+	serDesResponseMax = vector<unsigned> (NUM_LINK_BUSES,0);
 
 	responseLinkRoundRobin = vector<unsigned> (NUM_LINK_BUSES,0);
+	responseLinkBytes = vector<uint64_t> (NUM_LINK_BUSES,0);
+
+	requestLinkLanes = vector<unsigned> (NUM_LINK_BUSES,REQUEST_LINK_BUS_WIDTH);
+	responseLinkLanes = vector<unsigned> (NUM_LINK_BUSES,RESPONSE_LINK_BUS_WIDTH);
+	linkLaneShift = vector<unsigned> (NUM_LINK_BUSES,0);
+	linkClockDivider = vector<unsigned> (NUM_LINK_BUSES,1);
+	targetLaneShift = vector<unsigned> (NUM_LINK_BUSES,0);
+	targetClockDivider = vector<unsigned> (NUM_LINK_BUSES,1);
+	targetRequestLanes = vector<unsigned> (NUM_LINK_BUSES,REQUEST_LINK_BUS_WIDTH);
+	linkReconfigCountdown = vector<unsigned> (NUM_LINK_BUSES,0);
+	requestLinkBusyInterval = vector<unsigned> (NUM_LINK_BUSES,0);
+	responseLinkBusyInterval = vector<unsigned> (NUM_LINK_BUSES,0);
+	linkEnergy = vector<double> (NUM_LINK_BUSES,0);
+	requestLanesOnAvg = vector<uint64_t> (NUM_LINK_BUSES,0);
+	responseLanesOnAvg = vector<uint64_t> (NUM_LINK_BUSES,0);
+	linkClockDividerAvg = vector<uint64_t> (NUM_LINK_BUSES,0);
+	linkReconfigs = vector<unsigned> (NUM_LINK_BUSES,0);
+	linkReconfigCycles = vector<unsigned> (NUM_LINK_BUSES,0);
+	laneSwitches = vector<unsigned> (NUM_LINK_BUSES,0);
+	responseWaitHistogram = vector< vector<uint64_t> > (NUM_CHANNELS, vector<uint64_t>(RESPONSE_WAIT_HISTOGRAM_BINS,0));
+	responseWaitMax = vector<unsigned> (NUM_CHANNELS,0);
 
 	channelCounters = vector<unsigned>(NUM_CHANNELS,0);
 	channelCountersLifetime = vector<uint64_t>(NUM_CHANNELS,0);
+	requestsInTransit = vector<unsigned>(NUM_CHANNELS,0);
+	logicOpsInTransit = vector<unsigned>(NUM_CHANNELS,0);
+	logicOpsHeld = vector<unsigned>(NUM_CHANNELS,0);
 
-	portInputBufferAvg = vector<uint> (NUM_PORTS, 0);
-	portOutputBufferAvg = vector<uint> (NUM_PORTS, 0);
+	portInputBufferAvg = vector<uint64_t> (NUM_PORTS, 0);
+	portOutputBufferAvg = vector<uint64_t> (NUM_PORTS, 0);
+	portOccupancyUpdated = vector<uint64_t> (NUM_PORTS, 0);
 
 	requestLinkIdle = vector<unsigned> (NUM_LINK_BUSES,0);
+	requestLinkReadPackets = vector<unsigned> (NUM_LINK_BUSES,0);
+	requestLinkReads = vector<unsigned> (NUM_LINK_BUSES,0);
+	requestLinkBytes = vector<uint64_t> (NUM_LINK_BUSES,0);
+	requestLinkEquivalentBytes = vector<uint64_t> (NUM_LINK_BUSES,0);
 	responseLinkIdle = vector<unsigned> (NUM_LINK_BUSES,0);
 
 	cmdQFull = vector<uint>(NUM_CHANNELS,0);
+	portsWithRequests = vector<Bitmap>(NUM_LINK_BUSES, Bitmap(NUM_PORTS));
+	linkPriorityPort = vector<unsigned>(NUM_LINK_BUSES,0);
+
+	//all ports start out empty
+	portsAtInputLevel = vector<Bitmap>(PORT_QUEUE_DEPTH+1, Bitmap(NUM_PORTS));
+	portsAtLoadLevel = vector<Bitmap>(PORT_LOAD_LEVELS, Bitmap(NUM_PORTS));
+	portInputLevel = vector<unsigned>(NUM_PORTS,0);
+	portLoadLevel = vector<unsigned>(NUM_PORTS,0);
+	for(unsigned p=0; p<NUM_PORTS; p++)
+	{
+		portsAtInputLevel[0].Set(p);
+		portsAtLoadLevel[0].Set(p);
+	}
 
 	//Define callback function
 	Callback<BOB, void, BusPacket*, unsigned> *reportCallback = new Callback<BOB, void, BusPacket*, unsigned>(this, &BOB::ReportCallback);
@@ -145,8 +203,203 @@ BOB::BOB() : priorityPort(0),
 		channels.push_back(new DRAMChannel(i,reportCallback));
 	}
 
+	//logic layers need to know where the data they write lives
+	Callback<BOB, unsigned, uint64_t, unsigned> *channelCallback = new Callback<BOB, unsigned, uint64_t, unsigned>(this, &BOB::LogicChannelOf);
+	for(unsigned i=0; i<NUM_CHANNELS; i++)
+	{
+		channels[i]->logicLayer->RegisterChannelCallback(channelCallback);
+	}
+
+	//and reach the backing store of the channel a line belongs to
+	Callback<BOB, LogicLayerInterface*, uint64_t, unsigned> *layerCallback = new Callback<BOB, LogicLayerInterface*, uint64_t, unsigned>(this, &BOB::LogicLayerOf);
+	for(unsigned i=0; i<NUM_CHANNELS; i++)
+	{
+		channels[i]->logicLayer->RegisterLayerCallback(layerCallback);
+	}
+
+	//and the read buffer needs to know about lines they write
+	Callback<BOB, void, uint64_t, unsigned> *logicWriteCallback = new Callback<BOB, void, uint64_t, unsigned>(this, &BOB::LogicWrite);
+	for(unsigned i=0; i<NUM_CHANNELS; i++)
+	{
+		channels[i]->logicLayer->RegisterWriteCallback(logicWriteCallback);
+	}
+	logicTransferCountdown = 0;
+	logicTransferRoundRobin = 0;
+	logicTransfersDone = 0;
+	logicTransferLatency = 0;
+	logicTransferBytes = 0;
+	logicTransferBusy = 0;
+
 	//Used for round-robin
-	priorityLinkBus = vector<unsigned>(NUM_PORTS,0);
+	portsInputBusy = Bitmap(NUM_PORTS);
+	portsOutputBusy = Bitmap(NUM_PORTS);
+	portsWithOutput = Bitmap(NUM_PORTS);
+
+	readBufferHitLatency = 0;
+	readBufferMissLatency = 0;
+	readBufferMisses = 0;
+
+	readsCoalesced = 0;
+	readWaitersFull = 0;
+}
+
+//Builds the routing tables from LINK_TOPOLOGY so that finding a channel's link bus
+//  and hop is a table lookup for every request
+void BOB::BuildTopology()
+{
+	string topology = LINK_TOPOLOGY;
+
+	//default is CHANNELS_PER_LINK_BUS consecutive channels on each link bus
+	if(topology.empty())
+	{
+		ostringstream defaultTopology;
+		//Ensure that parameters have been set correclty
+		if(NUM_CHANNELS / CHANNELS_PER_LINK_BUS != NUM_LINK_BUSES)
+		{
+			ERROR("== ERROR - Mismatch in NUM_CHANNELS and NUM_LINK_BUSES");
+			exit(0);
+		}
+
+		for(unsigned l=0; l<NUM_LINK_BUSES; l++)
+		{
+			if(l>0) defaultTopology<<";";
+			for(unsigned c=0; c<CHANNELS_PER_LINK_BUS; c++)
+			{
+				if(c>0) defaultTopology<<",";
+				defaultTopology<<l*CHANNELS_PER_LINK_BUS + c;
+			}
+		}
+		topology = defaultTopology.str();
+	}
+
+	channelLink = vector<unsigned>(NUM_CHANNELS, NUM_LINK_BUSES);
+	channelHop = vector<unsigned>(NUM_CHANNELS, 0);
+	channelSlot = vector<unsigned>(NUM_CHANNELS, 0);
+	linkChannels = vector< vector<unsigned> >(NUM_LINK_BUSES);
+	hopLatency = vector< vector<unsigned> >(NUM_LINK_BUSES, vector<unsigned>(1,0));
+	hopRequestLanes = vector< vector<unsigned> >(NUM_LINK_BUSES, vector<unsigned>(1,0));
+	hopResponseLanes = vector< vector<unsigned> >(NUM_LINK_BUSES, vector<unsigned>(1,0));
+	numBuffers = 0;
+
+	//link buses are separated by ';'
+	unsigned link = 0;
+	size_t linkStart = 0;
+	while(linkStart<=topology.size())
+	{
+		size_t linkEnd = min(topology.find(';', linkStart), topology.size());
+		string linkDesc = topology.substr(linkStart, linkEnd-linkStart);
+		if(link>=NUM_LINK_BUSES)
+		{
+			ERROR("== ERROR - LINK_TOPOLOGY \""<<LINK_TOPOLOGY<<"\" has more than NUM_LINK_BUSES ("<<NUM_LINK_BUSES<<") link buses");
+			exit(0);
+		}
+
+		//buffers along the link bus are separated by '>'
+		unsigned hop = 0;
+		size_t bufferStart = 0;
+		while(bufferStart<=linkDesc.size())
+		{
+			size_t bufferEnd = min(linkDesc.find('>', bufferStart), linkDesc.size());
+			string bufferDesc = linkDesc.substr(bufferStart, bufferEnd-bufferStart);
+
+			//the hop leading to this buffer can be set after an '@'
+			size_t at = bufferDesc.find('@');
+			if(hop>0)
+			{
+				unsigned latency = DAISY_CHAIN_HOP_LATENCY;
+				unsigned requestLanes = DAISY_CHAIN_HOP_REQUEST_LANES;
+				unsigned responseLanes = DAISY_CHAIN_HOP_RESPONSE_LANES;
+				if(at!=string::npos)
+				{
+					int fields = sscanf(bufferDesc.c_str()+at+1, "%u/%u/%u", &latency, &requestLanes, &responseLanes);
+					if(fields!=1 && fields!=3)
+					{
+						ERROR("== ERROR - Bad hop \""<<bufferDesc.substr(at)<<"\" in LINK_TOPOLOGY - expected @latency or @latency/requestLanes/responseLanes");
+						exit(0);
+					}
+				}
+				if(requestLanes==0 || responseLanes==0)
+				{
+					ERROR("== ERROR - Hop to buffer "<<hop<<" on link bus "<<link<<" has no lanes");
+					exit(0);
+				}
+				hopLatency[link].push_back(latency);
+				hopRequestLanes[link].push_back(requestLanes);
+				hopResponseLanes[link].push_back(responseLanes);
+			}
+			else if(at!=string::npos)
+			{
+				ERROR("== ERROR - The first buffer on link bus "<<link<<" is on the link bus itself and has no hop to set");
+				exit(0);
+			}
+
+			//channels on the buffer are separated by ','
+			string channelList = bufferDesc.substr(0, at);
+			size_t channelStart = 0;
+			while(channelStart<=channelList.size())
+			{
+				size_t channelEnd = min(channelList.find(',', channelStart), channelList.size());
+				string channelDesc = channelList.substr(channelStart, channelEnd-channelStart);
+				char *end;
+				unsigned long chan = strtoul(channelDesc.c_str(), &end, 10);
+				if(channelDesc.empty() || *end!='\0' || chan>=NUM_CHANNELS)
+				{
+					ERROR("== ERROR - Bad channel \""<<channelDesc<<"\" in LINK_TOPOLOGY (NUM_CHANNELS is "<<NUM_CHANNELS<<")");
+					exit(0);
+				}
+				if(channelLink[chan]!=NUM_LINK_BUSES)
+				{
+					ERROR("== ERROR - Channel "<<chan<<" is given more than once in LINK_TOPOLOGY");
+					exit(0);
+				}
+
+				channelLink[chan] = link;
+				channelHop[chan] = hop;
+				channelSlot[chan] = linkChannels[link].size();
+				linkChannels[link].push_back(chan);
+				if(hop>0) forwardedChannels.push_back(chan);
+
+				channelStart = channelEnd+1;
+			}
+
+			numBuffers++;
+			hop++;
+			bufferStart = bufferEnd+1;
+		}
+
+		link++;
+		linkStart = linkEnd+1;
+	}
+
+	if(link!=NUM_LINK_BUSES)
+	{
+		ERROR("== ERROR - LINK_TOPOLOGY \""<<LINK_TOPOLOGY<<"\" has "<<link<<" link buses but NUM_LINK_BUSES is "<<NUM_LINK_BUSES);
+		exit(0);
+	}
+	for(unsigned c=0; c<NUM_CHANNELS; c++)
+	{
+		if(channelLink[c]==NUM_LINK_BUSES)
+		{
+			ERROR("== ERROR - Channel "<<c<<" is not on any link bus in LINK_TOPOLOGY");
+			exit(0);
+		}
+	}
+
+	hopRequestFree = vector< vector<uint64_t> >(NUM_LINK_BUSES);
+	hopResponseFree = vector< vector<uint64_t> >(NUM_LINK_BUSES);
+	hopRequestBusy = vector< vector<uint64_t> >(NUM_LINK_BUSES);
+	hopResponseBusy = vector< vector<uint64_t> >(NUM_LINK_BUSES);
+	for(unsigned l=0; l<NUM_LINK_BUSES; l++)
+	{
+		hopRequestFree[l] = vector<uint64_t>(hopLatency[l].size(), 0);
+		hopResponseFree[l] = vector<uint64_t>(hopLatency[l].size(), 0);
+		hopRequestBusy[l] = vector<uint64_t>(hopLatency[l].size(), 0);
+		hopResponseBusy[l] = vector<uint64_t>(hopLatency[l].size(), 0);
+	}
+	forwardedRequests = vector< deque< pair<uint64_t, Transaction *> > >(NUM_CHANNELS);
+	forwardedResponses = vector< deque<uint64_t> >(NUM_CHANNELS);
+
+	cout<<"Link topology : "<<topology<<" ("<<numBuffers<<" buffers)"<<endl;
 }
 
 void BOB::Update()
@@ -194,15 +447,35 @@ void BOB::Update()
 		{
 			responseLinkIdle[i]++;
 		}
-	}
 
-	//keep track of average entries in port in/out-buffers
-	for(unsigned i=0; i<NUM_PORTS; i++)
-	{
-		portInputBufferAvg[i] += ports[i].inputBuffer.size();
-		portOutputBufferAvg[i] += ports[i].outputBuffer.size();
+		//keep track of link power
+		unsigned reqLanes = RequestLinkWidth(i);
+		unsigned rspLanes = ResponseLinkWidth(i);
+		linkEnergy[i] += ((inFlightRequestLink[i]==NULL ? LINK_LANE_IDLE_POWER : LINK_LANE_ACTIVE_POWER) * reqLanes +
+		                  (inFlightResponseLink[i]==NULL ? LINK_LANE_IDLE_POWER : LINK_LANE_ACTIVE_POWER) * rspLanes) / linkClockDivider[i] +
+		                 LINK_LANE_OFF_POWER * (requestLinkLanes[i] - reqLanes + responseLinkLanes[i] - rspLanes);
+		requestLanesOnAvg[i] += reqLanes;
+		responseLanesOnAvg[i] += rspLanes;
+		linkClockDividerAvg[i] += linkClockDivider[i];
+		//a direction counts as busy if it is sending or has something waiting to send
+		if(inFlightRequestLink[i]!=NULL || serDesBufferRequest[i].size()>0) requestLinkBusyInterval[i]++;
+		bool responseWaiting = inFlightResponseLink[i]!=NULL;
+		for(unsigned c=0; c<linkChannels[i].size() && !responseWaiting; c++)
+		{
+			unsigned chan = linkChannels[i][c];
+			responseWaiting = channels[chan]->readReturnQueue.size()>0 || channels[chan]->pendingLogicResponse!=NULL;
+		}
+		if(responseWaiting) responseLinkBusyInterval[i]++;
+
+		//keep track of SerDes buffer occupancy
+		serDesRequestOccupancy[i] += serDesBufferRequest[i].size();
+		serDesResponseOccupancy[i] += serDesBufferResponse[i].size();
+		serDesRequestMax[i] = max<unsigned>(serDesRequestMax[i], serDesBufferRequest[i].size());
+		serDesResponseMax[i] = max<unsigned>(serDesResponseMax[i], serDesBufferResponse[i].size());
 	}
 
+	UpdateLinkConfiguration();
+
 
 	//
 	// DEBUG OUTPUT
@@ -215,10 +488,13 @@ void BOB::Update()
 		for(unsigned i=0; i<NUM_PORTS; i++)
 		{
 			DEBUG("== Port "<<i);
-			DEBUG(" - Input Buffer ("<<ports[i].inputBuffer.size()<<") == Busy Countdown:"<<ports[i].inputBusyCountdown);
-			for(unsigned j=0; j<ports[i].inputBuffer.size(); j++)
+			DEBUG(" - Input Buffer ("<<ports[i].inputBufferCount<<") == Busy Countdown:"<<ports[i].inputBusyCountdown);
+			for(unsigned l=0; l<NUM_LINK_BUSES; l++)
 			{
-				DEBUG("   "<<j<<"] "<<*ports[i].inputBuffer[j]);
+				for(unsigned j=0; j<ports[i].inputQueues[l].size(); j++)
+				{
+					DEBUG("   link "<<l<<" - "<<j<<"] "<<*ports[i].inputQueues[l][j]);
+				}
 			}
 			DEBUG(" - Output Buffer ("<<ports[i].outputBuffer.size()<<") == Busy Countdown:"<<ports[i].outputBusyCountdown);
 			for(unsigned j=0; j<ports[i].outputBuffer.size(); j++)
@@ -230,24 +506,16 @@ void BOB::Update()
 		DEBUG("== SerDe Buffers");
 		for(unsigned i=0; i<NUM_LINK_BUSES; i++)
 		{
-			DEBUGN("   "<<i<<"] request: ");
-			if(serDesBufferRequest[i]==NULL)
-			{
-				DEBUGN("NULL");
-			}
-			else
+			DEBUG("   "<<i<<"] request ("<<serDesBufferRequest[i].size()<<"/"<<SERDES_BUFFER_DEPTH<<")");
+			for(unsigned j=0; j<serDesBufferRequest[i].size(); j++)
 			{
-				DEBUGN(*serDesBufferRequest[i]);
+				DEBUG("      "<<j<<"] "<<*serDesBufferRequest[i][j]);
 			}
 
-			DEBUGN("   response: ");
-			if(serDesBufferResponse[i]==NULL)
-			{
-				DEBUG("NULL");
-			}
-			else
+			DEBUG("   "<<i<<"] response ("<<serDesBufferResponse[i].size()<<"/"<<SERDES_BUFFER_DEPTH<<")");
+			for(unsigned j=0; j<serDesBufferResponse[i].size(); j++)
 			{
-				DEBUG(*serDesBufferResponse[i]);
+				DEBUG("      "<<j<<"] "<<*serDesBufferResponse[i][j]);
 			}
 		}
 
@@ -290,23 +558,21 @@ void BOB::Update()
 	// UPDATE BUSES
 	//
 	if(DEBUG_BOB)DEBUG("== Bus Movement");
-	//update each port's bookkeeping
-	for(unsigned i=0; i<NUM_PORTS; i++)
+	//update each busy port's bookkeeping
+	for(int i=portsInputBusy.FindNextSet(0); i!=-1; i=portsInputBusy.FindNextSet(i+1))
 	{
-		if(ports[i].inputBusyCountdown>0)
+		ports[i].inputBusyCountdown--;
+		if(ports[i].inputBusyCountdown==0)
 		{
-			ports[i].inputBusyCountdown--;
-
-			//if the port input is done sending, erase that item
-			if(ports[i].inputBusyCountdown==0)
-			{
-
-			}
+			portsInputBusy.Clear(i);
 		}
-
-		if(ports[i].outputBusyCountdown>0)
+	}
+	for(int i=portsOutputBusy.FindNextSet(0); i!=-1; i=portsOutputBusy.FindNextSet(i+1))
+	{
+		ports[i].outputBusyCountdown--;
+		if(ports[i].outputBusyCountdown==0)
 		{
-			ports[i].outputBusyCountdown--;
+			portsOutputBusy.Clear(i);
 		}
 	}
 
@@ -318,18 +584,26 @@ void BOB::Update()
 
 			if(inFlightRequestLinkCountdowns[i]==0)
 			{
-				//compute total time in serDes and travel up channel
-				inFlightRequestLink[i]->cyclesReqLink = currentClockCycle - inFlightRequestLink[i]->cyclesReqLink;
-				if(DEBUG_BOB) DEBUG("  == Adding to channel "<<inFlightRequestLink[i]->mappedChannel<<" (from link bus "<<i<<") : "<<*inFlightRequestLink[i]);
+				//write data has to be decompressed before it can go to the channel
+				if(ENABLE_LINK_COMPRESSION && inFlightRequestLink[i]->transactionType==DATA_WRITE)
+				{
+					requestLinkDecompress[i].push_back(make_pair(currentClockCycle + COMPRESSOR_LATENCY + DECOMPRESSOR_LATENCY,
+					                                   inFlightRequestLink[i]));
+				}
+				else
+				{
+					DeliverToChannel(inFlightRequestLink[i], i);
+				}
 
-				//add to channel
-				channels[inFlightRequestLink[i]->mappedChannel]->AddTransaction(inFlightRequestLink[i], 0); //0 is not used
+				//any reads that were packed in with it arrive at the same time
+				for(unsigned j=0; j<coalescedRequests[i].size(); j++)
+				{
+					DeliverToChannel(coalescedRequests[i][j], i);
+				}
+				coalescedRequests[i].clear();
 
 				//remove from channel bus
 				inFlightRequestLink[i] = NULL;
-
-				//remove from SerDe buffer
-				serDesBufferRequest[i] = NULL;
 			}
 		}
 
@@ -339,26 +613,60 @@ void BOB::Update()
 
 			if(inFlightResponseLinkCountdowns[i]==0)
 			{
-				if(serDesBufferResponse[i]!=NULL)
+				//space was checked before the packet was put on the link
+				if(serDesBufferResponse[i].size()+responseLinkDecompress[i].size()>=SERDES_BUFFER_DEPTH)
 				{
-					ERROR("== Error - Response SerDe Buffer "<<i<<" collision");
+					ERROR("== Error - Response SerDe Buffer "<<i<<" overflow");
 					exit(0);
 				}
 
 				//note the time
 				inFlightResponseLink[i]->channelTimeTotal = currentClockCycle - inFlightResponseLink[i]->channelStartTime;
 
-				//remove from return queue
-				delete channels[inFlightResponseLink[i]->mappedChannel]->readReturnQueue[0];
-				channels[inFlightResponseLink[i]->mappedChannel]->readReturnQueue.erase(channels[inFlightResponseLink[i]->mappedChannel]->readReturnQueue.begin());
+				//remove from return queue and give back the space the read reserved (logic responses
+				//  never sat in the return queue)
+				if(inFlightResponseLink[i]->transactionType==RETURN_DATA)
+				{
+					delete channels[inFlightResponseLink[i]->mappedChannel]->readReturnQueue[0];
+					channels[inFlightResponseLink[i]->mappedChannel]->readReturnQueue.erase(channels[inFlightResponseLink[i]->mappedChannel]->readReturnQueue.begin());
+					channels[inFlightResponseLink[i]->mappedChannel]->simpleController.returnQueueReserved -= TRANSACTION_SIZE;
+				}
 
 
-				serDesBufferResponse[i] = inFlightResponseLink[i];
+				if(ENABLE_LINK_COMPRESSION && inFlightResponseLink[i]->transactionType==RETURN_DATA)
+				{
+					responseLinkDecompress[i].push_back(make_pair(currentClockCycle + COMPRESSOR_LATENCY + DECOMPRESSOR_LATENCY,
+					                                    inFlightResponseLink[i]));
+				}
+				else
+				{
+					serDesBufferResponse[i].push_back(inFlightResponseLink[i]);
+				}
 				inFlightResponseLink[i] = NULL;
 			}
 		}
+
+		//move along packets which are done being decompressed
+		while(requestLinkDecompress[i].size()>0 &&
+		        requestLinkDecompress[i][0].first<=currentClockCycle)
+		{
+			DeliverToChannel(requestLinkDecompress[i][0].second, i);
+			requestLinkDecompress[i].pop_front();
+		}
+		while(responseLinkDecompress[i].size()>0 &&
+		        responseLinkDecompress[i][0].first<=currentClockCycle)
+		{
+			serDesBufferResponse[i].push_back(responseLinkDecompress[i][0].second);
+			responseLinkDecompress[i].pop_front();
+		}
 	}
 
+	//move packets along daisy-chained buffers
+	UpdateDaisyChains();
+
+	//move data between logic layers
+	UpdateLogicTransfers();
+
 
 	//
 	// NEW STUFF
@@ -369,8 +677,10 @@ void BOB::Update()
 		//
 		//REQUEST
 		//
-		if(serDesBufferRequest[c]!=NULL &&
-		        inFlightRequestLinkCountdowns[c]==0)
+		//the link bus can start the next packet on the same cycle the previous one finished
+		if(serDesBufferRequest[c].size()>0 &&
+		        inFlightRequestLinkCountdowns[c]==0 &&
+		        LinkAvailable(c))
 		{
 			//error checking
 			if(inFlightRequestLink[c]!=NULL)
@@ -378,41 +688,60 @@ void BOB::Update()
 				ERROR("== Error - item in SerDe buffer without channel being free");
 				ERROR("   == Channel : "<<c);
 				ERROR("   == Current : "<<*inFlightRequestLink[c]);
-				ERROR("   == SerDe   : "<<*serDesBufferRequest[c]);
+				ERROR("   == SerDe   : "<<*serDesBufferRequest[c][0]);
 				exit(0);
 			}
 
 			//put on channel bus
-			inFlightRequestLink[c] = serDesBufferRequest[c];
+			inFlightRequestLink[c] = serDesBufferRequest[c][0];
+			serDesBufferRequest[c].pop_front();
 			//note the time
 			inFlightRequestLink[c]->channelStartTime = currentClockCycle;
 
-			//the total number of channel cycles the packet will be on the bus
-			unsigned totalChannelCycles;
+			//the total number of bytes in the packet
+			unsigned packetBytes;
 
 			if(inFlightRequestLink[c]->transactionType==DATA_READ)
 			{
-				//
-				//widths are in bits
-				//
-				totalChannelCycles = (RD_REQUEST_PACKET_OVERHEAD * 8) / REQUEST_LINK_BUS_WIDTH +
-				                     !!((RD_REQUEST_PACKET_OVERHEAD * 8) % REQUEST_LINK_BUS_WIDTH);
+				//pack the reads right behind it in the SerDe buffer into the same packet - never
+				//  past a write or logic op, which a read to the same line has to stay behind
+				while(serDesBufferRequest[c].size()>0 &&
+				        serDesBufferRequest[c][0]->transactionType==DATA_READ &&
+				        coalescedRequests[c].size()+1<REQUEST_COALESCING_MAX)
+				{
+					serDesBufferRequest[c][0]->channelStartTime = currentClockCycle;
+					coalescedRequests[c].push_back(serDesBufferRequest[c][0]);
+					serDesBufferRequest[c].pop_front();
+				}
+
+				unsigned numReads = coalescedRequests[c].size()+1;
+				if(numReads==1)
+				{
+					packetBytes = RD_REQUEST_PACKET_OVERHEAD;
+				}
+				else
+				{
+					packetBytes = COALESCED_REQUEST_HEADER + numReads * COALESCED_REQUEST_DESCRIPTOR;
+				}
+
+				requestLinkReadPackets[c]++;
+				requestLinkReads[c] += numReads;
+				requestLinkEquivalentBytes[c] += numReads * RD_REQUEST_PACKET_OVERHEAD;
 			}
 			else if(inFlightRequestLink[c]->transactionType==DATA_WRITE)
 			{
-				//
-				//widths are in bits
-				//
-				totalChannelCycles = ((WR_REQUEST_PACKET_OVERHEAD + TRANSACTION_SIZE) * 8) / REQUEST_LINK_BUS_WIDTH +
-				                     !!(((WR_REQUEST_PACKET_OVERHEAD + TRANSACTION_SIZE) * 8) % REQUEST_LINK_BUS_WIDTH);
+				unsigned payloadBytes = LinkPayloadSize(inFlightRequestLink[c]);
+				packetBytes = WR_REQUEST_PACKET_OVERHEAD + payloadBytes;
+				requestLinkEquivalentBytes[c] += WR_REQUEST_PACKET_OVERHEAD + TRANSACTION_SIZE;
+
+				requestPayloadBytes[c] += TRANSACTION_SIZE;
+				requestCompressedBytes[c] += payloadBytes;
+				if(ENABLE_LINK_COMPRESSION) compressedPackets[c]++;
 			}
 			else if(inFlightRequestLink[c]->transactionType==LOGIC_OPERATION)
 			{
-				//
-				//widths are in bits
-				//
-				totalChannelCycles = (inFlightRequestLink[c]->transactionSize * 8) / REQUEST_LINK_BUS_WIDTH +
-				                     !!((inFlightRequestLink[c]->transactionSize * 8) % REQUEST_LINK_BUS_WIDTH);
+				packetBytes = inFlightRequestLink[c]->transactionSize;
+				requestLinkEquivalentBytes[c] += packetBytes;
 			}
 			else
 			{
@@ -420,16 +749,8 @@ void BOB::Update()
 				exit(0);
 			}
 
-			//if the channel uses DDR signaling, the cycles is cut in half
-			if(LINK_BUS_USE_DDR)
-			{
-				totalChannelCycles = totalChannelCycles / 2 + !!(totalChannelCycles % 2);
-			}
-
-			//since the channel is faster than the CPU, figure out how many CPU
-			//  cycles the channel will be in use
-			inFlightRequestLinkCountdowns[c] = (totalChannelCycles / LINK_CPU_CLK_RATIO) +
-			                                   !!(totalChannelCycles%LINK_CPU_CLK_RATIO);
+			requestLinkBytes[c] += packetBytes;
+			inFlightRequestLinkCountdowns[c] = LinkBusCycles(packetBytes, RequestLinkWidth(c), linkClockDivider[c]);
 
 			//error check
 			if(inFlightRequestLinkCountdowns[c]==0)
@@ -441,7 +762,11 @@ void BOB::Update()
 			if(DEBUG_BOB)
 			{
 				DEBUG("  == Channel Bus "<<c<<" getting : "<<*inFlightRequestLink[c]);
-				DEBUG("     == CPU Clks:"<<inFlightRequestLinkCountdowns[c]<<"   Channel Clks:"<< totalChannelCycles<<" DDR?:"<<LINK_BUS_USE_DDR);
+				for(unsigned i=0; i<coalescedRequests[c].size(); i++)
+				{
+					DEBUG("                  with : "<<*coalescedRequests[c][i]);
+				}
+				DEBUG("     == CPU Clks:"<<inFlightRequestLinkCountdowns[c]<<"   Bytes:"<<packetBytes<<" DDR?:"<<LINK_BUS_USE_DDR);
 			}
 		}
 	}
@@ -450,173 +775,141 @@ void BOB::Update()
 	//
 	//Responses
 	//
-	for(unsigned p=0; p<NUM_PORTS; p++)
+	//reads answered by the read buffer go straight to their port
+	for(unsigned i=0; i<readBufferReturns.size() && readBufferReturns[i].first<=currentClockCycle; )
+	{
+		Transaction *trans = readBufferReturns[i].second;
+		if(ports[trans->portID].outputBusyCountdown>0)
+		{
+			i++;
+			continue;
+		}
+
+		readBufferHitLatency += currentClockCycle - trans->fullStartTime;
+		AddToOutputBuffer(trans);
+		readBufferReturns.erase(readBufferReturns.begin()+i);
+	}
+
+	//reads which were waiting on another read's data
+	for(unsigned i=0; i<coalescedReturns.size(); )
+	{
+		if(ports[coalescedReturns[i]->portID].outputBusyCountdown>0)
+		{
+			i++;
+			continue;
+		}
+
+		AddToOutputBuffer(coalescedReturns[i]);
+		coalescedReturns.erase(coalescedReturns.begin()+i);
+	}
+
+	//only the packets waiting in the SerDes buffers are looked at, so the work doesn't grow
+	//  with the number of ports - each port takes one packet at a time and the links take
+	//  turns going first
+	for(unsigned l=0; l<NUM_LINK_BUSES; l++)
 	{
-		if(ports[p].outputBusyCountdown==0)
+		//check to see if something has been received from a channel
+		deque<Transaction *> &serDes = serDesBufferResponse[(priorityResponseLink + l) % NUM_LINK_BUSES];
+		for(unsigned i=0; i<serDes.size(); )
 		{
-			//check to see if something has been received from a channel
-			if(serDesBufferResponse[priorityLinkBus[p]]!=NULL &&
-			        serDesBufferResponse[priorityLinkBus[p]]->portID==p)
+			unsigned p = serDes[i]->portID;
+			if(ports[p].outputBusyCountdown>0)
 			{
-				serDesBufferResponse[priorityLinkBus[p]]->cyclesRspLink = currentClockCycle - serDesBufferResponse[priorityLinkBus[p]]->cyclesRspLink;
-				serDesBufferResponse[priorityLinkBus[p]]->cyclesRspPort = currentClockCycle;
-				ports[p].outputBuffer.push_back(serDesBufferResponse[priorityLinkBus[p]]);
-				switch(serDesBufferResponse[priorityLinkBus[p]]->transactionType)
-				{
-				case RETURN_DATA:
-					ports[p].outputBusyCountdown = TRANSACTION_SIZE / PORT_WIDTH;
-					break;
-				case LOGIC_RESPONSE:
-					ports[p].outputBusyCountdown = 1;
-					break;
-				default:
-					ERROR("== ERROR - Trying to add wrong type of transaction to output port : "<<*serDesBufferResponse[priorityLinkBus[p]]);
-					exit(0);
-					break;
-				};
-				serDesBufferResponse[priorityLinkBus[p]] = NULL;
+				i++;
+				continue;
+			}
+
+			//keep the line around for the next read to it
+			if(ENABLE_READ_BUFFER && serDes[i]->transactionType==RETURN_DATA)
+			{
+				readBuffer.Fill(serDes[i]->address, serDes[i]->fullStartTime);
+				readBufferMissLatency += currentClockCycle - serDes[i]->fullStartTime;
+				readBufferMisses++;
 			}
-			priorityLinkBus[p]++;
-			if(priorityLinkBus[p]==NUM_LINK_BUSES)priorityLinkBus[p]=0;
+
+			AddToOutputBuffer(serDes[i]);
+			if(ENABLE_READ_COALESCING && serDes[i]->transactionType==RETURN_DATA)
+			{
+				ReleaseReadWaiters(serDes[i]);
+			}
+			serDes.erase(serDes.begin()+i);
 		}
 	}
+	priorityResponseLink++;
+	if(priorityResponseLink==NUM_LINK_BUSES) priorityResponseLink = 0;
 
 	//
 	//Move from input ports to serdes
 	//
 	if(DEBUG_BOB) DEBUG("== Moving from port buffer to SerDe");
-	for(unsigned port=0; port<NUM_PORTS; port++)
+	for(unsigned l=0; l<NUM_LINK_BUSES; l++)
 	{
-		unsigned p = priorityPort;
+		unsigned linkBusID = (priorityRequestLink + l) % NUM_LINK_BUSES;
 
-		if(DEBUG_BOB) DEBUG("  == Port "<<p);
-		//make sure the port isn't already sending something
-		//  and that there is an item there to send
-		if(ports[p].inputBusyCountdown==0 &&
-		        ports[p].inputBuffer.size()>0)
+		//make sure the serDe isn't full
+		if(serDesBufferRequest[linkBusID].size()>=SERDES_BUFFER_DEPTH)
 		{
-			//search out-of-order
-			for(unsigned i=0; i<ports[p].inputBuffer.size(); i++)
+			if(DEBUG_BOB)
 			{
-				unsigned channelID = FindChannelID(ports[p].inputBuffer[i]);
-				unsigned linkBusID = channelID / CHANNELS_PER_LINK_BUS;
-
-				//make sure the serDe isn't busy and the queue isn't full
-				if(serDesBufferRequest[linkBusID]==NULL &&
-				        channels[channelID]->simpleController.waitingACTS<CHANNEL_WORK_Q_MAX)
-				{
-					//put on channel bus
-					serDesBufferRequest[linkBusID] = ports[p].inputBuffer[i];
-					serDesBufferRequest[linkBusID]->cyclesReqLink = currentClockCycle;
-					serDesBufferRequest[linkBusID]->cyclesReqPort = currentClockCycle - serDesBufferRequest[linkBusID]->cyclesReqPort;
-					serDesBufferRequest[linkBusID]->mappedChannel = channelID;
-
-					//keep track of requests
-					channelCounters[channelID]++;
-
-					if(serDesBufferRequest[linkBusID]->transactionType==DATA_READ)
-					{
-						//put in pending queue
-						//  make it a RETURN_DATA type before we put it in pending queue
-						pendingReads.push_back(ports[p].inputBuffer[i]);
-
-						readCounter++;
-
-						//set port busy time
-						ports[p].inputBusyCountdown = 1;
-					}
-					else if(serDesBufferRequest[linkBusID]->transactionType==DATA_WRITE)
-					{
-						writeCounter++;
-
-						//set port busy time
-						ports[p].inputBusyCountdown = serDesBufferRequest[linkBusID]->transactionSize / PORT_WIDTH;
-					}
-					else if(serDesBufferRequest[linkBusID]->transactionType==LOGIC_OPERATION)
-					{
-						logicOpCounter++;
-
-						//set port busy time
-						ports[p].inputBusyCountdown = serDesBufferRequest[linkBusID]->transactionSize / PORT_WIDTH;
-					}
-					else
-					{
-						ERROR("== Error - unknown transaction type going to channel : "<<*serDesBufferRequest[linkBusID]);
-						exit(0);
-					}
-
-					if(DEBUG_BOB) DEBUG("    == Request SerDes "<<linkBusID<<" getting "<<*serDesBufferRequest[linkBusID]);
-
-					priorityPort++;
-					if(priorityPort==NUM_PORTS) priorityPort = 0;
+				DEBUG("    == Request SerDes "<<linkBusID<<" Full : "<<serDesBufferRequest[linkBusID].size()<<" packets");
+				DEBUG("             Left : "<<inFlightRequestLinkCountdowns[linkBusID]);
+			}
+			continue;
+		}
 
-					//remove from port input buffer
-					ports[p].inputBuffer.erase(ports[p].inputBuffer.begin()+i);
-					break;
-				}
-				else
+		//visit ports that have something for this link, starting after the last one served,
+		//  until the SerDe fills up (first pass to the end, second pass wraps around)
+		unsigned start = linkPriorityPort[linkBusID];
+		bool serDesFull = false;
+		for(unsigned pass=0; pass<2 && !serDesFull; pass++)
+		{
+			unsigned end = (pass==0) ? NUM_PORTS : start;
+			for(int p=portsWithRequests[linkBusID].FindNextSet(pass==0 ? start : 0, portsInputBusy);
+			        p!=-1 && (unsigned)p<end;
+			        p=portsWithRequests[linkBusID].FindNextSet(p+1, portsInputBusy))
+			{
+				if(MovePortToSerDes(p, linkBusID))
 				{
-					if(DEBUG_BOB)
-					{
-						if(serDesBufferRequest[linkBusID]!=NULL)
-						{
-							DEBUG("    == Request SerDes Full : "<<*serDesBufferRequest[linkBusID]);
-							DEBUG("             Left : "<<inFlightRequestLinkCountdowns[linkBusID]);
-						}
-
-						if(channels[channelID]->simpleController.waitingACTS>=CHANNEL_WORK_Q_MAX)
-						{
-							cmdQFull[channelID]++;
-							DEBUG("    == Channel Queue Full");
-						}
-					}
+					linkPriorityPort[linkBusID] = (p+1) % NUM_PORTS;
+					serDesFull = serDesBufferRequest[linkBusID].size()>=SERDES_BUFFER_DEPTH;
+					if(serDesFull) break;
 				}
 			}
 		}
-
-		priorityPort++;
-		if(priorityPort==NUM_PORTS) priorityPort = 0;
-
 	}
-	priorityPort++;
-	if(priorityPort==NUM_PORTS) priorityPort = 0;
+	priorityRequestLink++;
+	if(priorityRequestLink==NUM_LINK_BUSES) priorityRequestLink = 0;
 
 
 	if(DEBUG_BOB) DEBUG("== Move from channel return queue to SerDe buffer");
 	for(unsigned link=0; link<NUM_LINK_BUSES; link++)
 	{
-		//make sure output is not busy sending something else
+		//make sure output is not busy sending something else and there is
+		//  room in the SerDe buffer for the packet once it gets across
 		if(inFlightResponseLinkCountdowns[link]==0 &&
-		        serDesBufferResponse[link]==NULL)
+		        serDesBufferResponse[link].size()+responseLinkDecompress[link].size()<SERDES_BUFFER_DEPTH &&
+		        LinkAvailable(link))
 		{
 
-			for(unsigned z=0; z<CHANNELS_PER_LINK_BUS; z++)
+			//pick which channel on this link gets to send its response
+			unsigned chan;
+			if(SelectResponseChannel(link, chan))
 			{
-				unsigned chan = link * CHANNELS_PER_LINK_BUS + responseLinkRoundRobin[link];
-
-				//make sure something is there
+				//logic responses go ahead of data from the same channel
 				if(channels[chan]->pendingLogicResponse!=NULL)
 				{
 					//calculate numbers to see how long the response is on the bus
-					//
-					//widths are in bits
-					unsigned totalChannelCycles = (LOGIC_RESPONSE_PACKET_OVERHEAD * 8) / RESPONSE_LINK_BUS_WIDTH +
-					                              !!((LOGIC_RESPONSE_PACKET_OVERHEAD * 8) % RESPONSE_LINK_BUS_WIDTH);
-
-					if(LINK_BUS_USE_DDR)
-					{
-						totalChannelCycles = totalChannelCycles / 2 + !!(totalChannelCycles % 2);
-					}
+					unsigned packetBytes = LogicResponseSize(channels[chan]->pendingLogicResponse);
 
 					//channel countdown
-					inFlightResponseLinkCountdowns[link] = totalChannelCycles / LINK_CPU_CLK_RATIO +
-					                                       !!(totalChannelCycles % LINK_CPU_CLK_RATIO);
+					inFlightResponseLinkCountdowns[link] = LinkBusCycles(packetBytes, ResponseLinkWidth(link), linkClockDivider[link]);
+					responseLinkBytes[link] += packetBytes;
 
 					//make sure computation worked
 					if(inFlightResponseLinkCountdowns[link]==0)
 					{
 						ERROR("== ERROR - Countdown 0 on link "<<link);
-						ERROR("==         totalChannelCycles : "<<totalChannelCycles);
+						ERROR("==         packetBytes : "<<packetBytes);
 						exit(0);
 					}
 
@@ -640,10 +933,9 @@ void BOB::Update()
 					if(DEBUG_BOB)
 					{
 						DEBUG("  == Link Bus "<<link<<" returning "<<*inFlightResponseLink[link]);
-						DEBUG("     == CPU Clks:"<<inFlightResponseLinkCountdowns[link]<<"   Channel Clks:"<<totalChannelCycles<<" DDR?:"<<LINK_BUS_USE_DDR);
+						DEBUG("     == CPU Clks:"<<inFlightResponseLinkCountdowns[link]<<"   Bytes:"<<packetBytes<<" DDR?:"<<LINK_BUS_USE_DDR);
 					}
 
-					break;
 				}
 				else if(channels[chan]->readReturnQueue.size()>0)
 				{
@@ -657,19 +949,16 @@ void BOB::Update()
 							pendingReads[p]->transactionType = RETURN_DATA;
 
 							//calculate numbers to see how long the response is on the bus
-							//
-							//widths are in bits
-							unsigned totalChannelCycles = ((RD_RESPONSE_PACKET_OVERHEAD + TRANSACTION_SIZE) * 8) / RESPONSE_LINK_BUS_WIDTH +
-							                              !!(((RD_RESPONSE_PACKET_OVERHEAD+TRANSACTION_SIZE) * 8) % RESPONSE_LINK_BUS_WIDTH);
+							unsigned payloadBytes = LinkPayloadSize(pendingReads[p]);
+							unsigned packetBytes = RD_RESPONSE_PACKET_OVERHEAD + payloadBytes;
 
-							if(LINK_BUS_USE_DDR)
-							{
-								totalChannelCycles = totalChannelCycles / 2 + !!(totalChannelCycles % 2);
-							}
+							responsePayloadBytes[link] += TRANSACTION_SIZE;
+							responseCompressedBytes[link] += payloadBytes;
+							if(ENABLE_LINK_COMPRESSION) compressedPackets[link]++;
 
 							//channel countdown
-							inFlightResponseLinkCountdowns[link] = totalChannelCycles / LINK_CPU_CLK_RATIO
-							                                       + !!(totalChannelCycles % LINK_CPU_CLK_RATIO);
+							inFlightResponseLinkCountdowns[link] = LinkBusCycles(packetBytes, ResponseLinkWidth(link), linkClockDivider[link]);
+							responseLinkBytes[link] += packetBytes;
 
 							//make sure computation worked
 							if(inFlightResponseLinkCountdowns[link]==0)
@@ -694,10 +983,17 @@ void BOB::Update()
 							//note the time
 							inFlightResponseLink[link]->cyclesRspLink = currentClockCycle;
 
+							//keep track of how long the data sat in the return queue
+							unsigned bin = inFlightResponseLink[link]->cyclesInReadReturnQ / RESPONSE_WAIT_HISTOGRAM_BIN_SIZE;
+							if(bin>=RESPONSE_WAIT_HISTOGRAM_BINS) bin = RESPONSE_WAIT_HISTOGRAM_BINS-1;
+							responseWaitHistogram[chan][bin]++;
+							if(inFlightResponseLink[link]->cyclesInReadReturnQ>responseWaitMax[chan])
+								responseWaitMax[chan] = inFlightResponseLink[link]->cyclesInReadReturnQ;
+
 							if(DEBUG_BOB)
 							{
 								DEBUG("  == Link Bus "<<link<<" returning "<<*inFlightResponseLink[link]);
-								DEBUG("     == CPU Clks:"<<inFlightResponseLinkCountdowns[link]<<"   Channel Clks:"<<totalChannelCycles<<" DDR?:"<<LINK_BUS_USE_DDR);
+								DEBUG("     == CPU Clks:"<<inFlightResponseLinkCountdowns[link]<<"   Bytes:"<<packetBytes<<" DDR?:"<<LINK_BUS_USE_DDR);
 							}
 
 							//remove pending queues
@@ -709,21 +1005,17 @@ void BOB::Update()
 						}
 					}
 
-					//check to see if we cound an item, and break out of the loop over chans_per_link
-					if(inFlightResponseLinkCountdowns[link]>0)
-					{
-						//increment round robin (increment here to go to next index before we break)
-						responseLinkRoundRobin[link]++;
-						if(responseLinkRoundRobin[link]==CHANNELS_PER_LINK_BUS)
-							responseLinkRoundRobin[link]=0;
+				}
 
-						break;
-					}
+				//the response has left the first buffer, so the next one can be forwarded
+				if(channelHop[chan]>0)
+				{
+					forwardedResponses[chan].pop_front();
 				}
 
-				//increment round robin (increment here if we found nothing)
-				responseLinkRoundRobin[link]++;
-				if(responseLinkRoundRobin[link]==CHANNELS_PER_LINK_BUS)
+				//round robin (and tie-breaking for the other schemes) starts after the channel that was picked
+				responseLinkRoundRobin[link] = channelSlot[chan] + 1;
+				if(responseLinkRoundRobin[link]==linkChannels[link].size())
 					responseLinkRoundRobin[link]=0;
 			}
 
@@ -771,32 +1063,788 @@ void BOB::Update()
 	currentClockCycle++;
 }
 
-unsigned BOB::FindChannelID(Transaction* trans)
+//Classifies a request coming in on port by the link bus it is headed to
+void BOB::AddToInputBuffer(Transaction *trans, unsigned port)
 {
-	unsigned channelID = 0;
-	unsigned bitWidth = log2(NUM_CHANNELS);
-	uint64_t channelMask = 0;
-	unsigned channelIDOffset;// = log2(BUS_ALIGNMENT_SIZE) + CHANNEL_ID_OFFSET;
+	trans->mappedChannel = FindChannelID(trans);
+	unsigned linkBusID = channelLink[trans->mappedChannel];
 
-	switch(mappingScheme)
+	if(ENABLE_READ_BUFFER)
 	{
-	case BK_CLH_RW_RK_CH_CLL_BY://bank:col_high:row:rank:chan:col_low:by
-		channelIDOffset = cacheOffset;//bus alignment + column low bits should make the cache offset
-		break;
-	case CLH_RW_RK_BK_CH_CLL_BY://col_high:row:rank:bank:chan:col_low:byte
-		channelIDOffset = cacheOffset;//bus alignment + column low bits should make the cache offset
-		break;
-	case RK_BK_RW_CLH_CH_CLL_BY://rank:bank:row:col_high:chan:col_low:by
-		channelIDOffset = cacheOffset;//bus alignment + column low bits should make the cache offset
+		if(trans->transactionType==DATA_READ && readBuffer.Lookup(trans->address))
+		{
+			//answered right here without going to the channel
+			if(DEBUG_BOB) DEBUG("  == Read buffer hit : "<<*trans);
+			trans->transactionType = RETURN_DATA;
+			trans->cyclesReqPort = currentClockCycle - trans->cyclesReqPort;
+			trans->cyclesRspLink = currentClockCycle;
+			readBufferReturns.push_back(make_pair(currentClockCycle + READ_BUFFER_LATENCY, trans));
+			return;
+		}
+		else if(trans->transactionType==DATA_WRITE)
+		{
+			readBuffer.Write(trans->address, currentClockCycle);
+		}
+	}
+
+	if(ENABLE_READ_COALESCING)
+	{
+		uint64_t line = trans->address >> cacheOffset;
+		if(trans->transactionType==DATA_READ)
+		{
+			map<uint64_t, unsigned>::iterator it = outstandingReadLines.find(line);
+			if(it==outstandingReadLines.end())
+			{
+				outstandingReadLines[line] = trans->transactionID;
+			}
+			else if(readWaiters[it->second].size()<READ_COALESCING_MAX_WAITERS)
+			{
+				//wait for the data of the read that is already out
+				if(DEBUG_BOB) DEBUG("  == Coalescing "<<*trans<<" with T"<<it->second);
+				trans->cyclesReqPort = currentClockCycle - trans->cyclesReqPort;
+				readWaiters[it->second].push_back(trans);
+				readsCoalesced++;
+				return;
+			}
+			else
+			{
+				readWaitersFull++;
+			}
+		}
+		else if(trans->transactionType==DATA_WRITE)
+		{
+			outstandingReadLines.erase(line);
+		}
+	}
+
+	UpdatePortOccupancy(port);
+	ports[port].inputQueues[linkBusID].push_back(trans);
+	ports[port].inputBufferCount++;
+	portsWithRequests[linkBusID].Set(port);
+	UpdatePortLoad(port);
+}
+
+//Puts a response in its port's output buffer and keeps the port busy while it is moved in
+void BOB::AddToOutputBuffer(Transaction *trans)
+{
+	unsigned p = trans->portID;
+
+	trans->cyclesRspLink = currentClockCycle - trans->cyclesRspLink;
+	trans->cyclesRspPort = currentClockCycle;
+	UpdatePortOccupancy(p);
+	ports[p].outputBuffer.push_back(trans);
+	portsWithOutput.Set(p);
+	switch(trans->transactionType)
+	{
+	case RETURN_DATA:
+		ports[p].outputBusyCountdown = TRANSACTION_SIZE / PORT_WIDTH;
 		break;
-	case RW_BK_RK_CH_CL_BY://row:bank:rank:chan:col:byte
-		channelIDOffset = colBitWidth + busOffsetBitWidth;
+	case LOGIC_RESPONSE:
+		ports[p].outputBusyCountdown = LogicResponsePortCycles(trans);
 		break;
-	case RW_CH_BK_RK_CL_BY://row:chan:bank:rank:col:byte
-		channelIDOffset = busOffsetBitWidth + colBitWidth + rankBitWidth + bankBitWidth;
+	default:
+		ERROR("== ERROR - Trying to add wrong type of transaction to output port : "<<*trans);
+		exit(0);
 		break;
-	case RW_BK_RK_CLH_CH_CLL_BY://row:bank:rank:col_high:chan:col_low:byte
-		channelIDOffset = cacheOffset; //bus alignment + column low bits should make the cache offset
+	};
+	portsOutputBusy.Set(p);
+}
+
+//Sends the data of a read that came back to every read which was waiting on it
+void BOB::ReleaseReadWaiters(Transaction *trans)
+{
+	map<uint64_t, unsigned>::iterator line = outstandingReadLines.find(trans->address >> cacheOffset);
+	if(line!=outstandingReadLines.end() && line->second==trans->transactionID)
+	{
+		outstandingReadLines.erase(line);
+	}
+
+	map<unsigned, vector<Transaction *> >::iterator it = readWaiters.find(trans->transactionID);
+	if(it==readWaiters.end()) return;
+
+	for(unsigned i=0; i<it->second.size(); i++)
+	{
+		Transaction *waiter = it->second[i];
+		waiter->transactionType = RETURN_DATA;
+		waiter->mappedChannel = trans->mappedChannel;
+
+		//the waiter saw the same trip as the read it waited on
+		waiter->cyclesReqLink = trans->cyclesReqLink;
+		waiter->cyclesInWorkQueue = trans->cyclesInWorkQueue;
+		waiter->dramTimeTotal = trans->dramTimeTotal;
+		waiter->cyclesInReadReturnQ = trans->cyclesInReadReturnQ;
+		waiter->channelTimeTotal = trans->channelTimeTotal;
+		waiter->cyclesRspLink = currentClockCycle - trans->cyclesRspLink;
+
+		coalescedReturns.push_back(waiter);
+	}
+	readWaiters.erase(it);
+}
+
+//Brings a port's buffer averages up to date - called before its buffers change
+void BOB::UpdatePortOccupancy(unsigned port)
+{
+	uint64_t cycles = currentClockCycle - portOccupancyUpdated[port];
+	portInputBufferAvg[port] += cycles * ports[port].inputBufferCount;
+	portOutputBufferAvg[port] += cycles * ports[port].outputBuffer.size();
+	portOccupancyUpdated[port] = currentClockCycle;
+}
+
+//Moves a port to the right occupancy groups after its input buffer or pending responses change
+void BOB::UpdatePortLoad(unsigned port)
+{
+	portsAtInputLevel[portInputLevel[port]].Clear(port);
+	portInputLevel[port] = min(ports[port].inputBufferCount, PORT_QUEUE_DEPTH);
+	portsAtInputLevel[portInputLevel[port]].Set(port);
+
+	portsAtLoadLevel[portLoadLevel[port]].Clear(port);
+	portLoadLevel[port] = min(ports[port].inputBufferCount + ports[port].responsesPending, PORT_LOAD_LEVELS-1);
+	portsAtLoadLevel[portLoadLevel[port]].Set(port);
+}
+
+//Sends the oldest request in port p's queue for link linkBusID whose channel has room.
+//  Returns false if none of them can go.
+bool BOB::MovePortToSerDes(unsigned p, unsigned linkBusID)
+{
+	deque<Transaction *> &queue = ports[p].inputQueues[linkBusID];
+
+	//search out-of-order
+	for(unsigned i=0; i<queue.size(); i++)
+	{
+		unsigned channelID = queue[i]->mappedChannel;
+
+		//make sure the queue won't be full once everything already headed to that channel gets there
+		if(channels[channelID]->simpleController.waitingACTS + requestsInTransit[channelID]>=CHANNEL_WORK_Q_MAX)
+		{
+			if(DEBUG_BOB) DEBUG("    == Channel "<<channelID<<" Queue Full");
+			continue;
+		}
+
+		//logic ops need a spot in the logic layer's queue as well
+		if(queue[i]->transactionType==LOGIC_OPERATION &&
+		        channels[channelID]->logicLayer->pendingLogicOpsQueue.size() + logicOpsInTransit[channelID]>=LOGIC_OP_QUEUE_DEPTH)
+		{
+			if(DEBUG_BOB) DEBUG("    == Channel "<<channelID<<" Logic Queue Full");
+			logicOpsHeld[channelID]++;
+			continue;
+		}
+
+		Transaction *trans = queue[i];
+
+		//put in SerDe buffer
+		serDesBufferRequest[linkBusID].push_back(trans);
+		trans->cyclesReqLink = currentClockCycle;
+		trans->cyclesReqPort = currentClockCycle - trans->cyclesReqPort;
+
+		//keep track of requests
+		channelCounters[channelID]++;
+		requestsInTransit[channelID]++;
+
+		if(trans->transactionType==DATA_READ)
+		{
+			//put in pending queue
+			//  make it a RETURN_DATA type before we put it in pending queue
+			pendingReads.push_back(trans);
+
+			readCounter++;
+
+			//set port busy time
+			ports[p].inputBusyCountdown = 1;
+		}
+		else if(trans->transactionType==DATA_WRITE)
+		{
+			writeCounter++;
+
+			//set port busy time
+			ports[p].inputBusyCountdown = trans->transactionSize / PORT_WIDTH;
+		}
+		else if(trans->transactionType==LOGIC_OPERATION)
+		{
+			logicOpCounter++;
+			logicOpsInTransit[channelID]++;
+
+			//set port busy time
+			ports[p].inputBusyCountdown = trans->transactionSize / PORT_WIDTH;
+		}
+		else
+		{
+			ERROR("== Error - unknown transaction type going to channel : "<<*trans);
+			exit(0);
+		}
+
+		if(DEBUG_BOB) DEBUG("    == Request SerDes "<<linkBusID<<" getting "<<*trans<<" from port "<<p);
+
+		portsInputBusy.Set(p);
+
+		//remove from port input buffer
+		UpdatePortOccupancy(p);
+		queue.erase(queue.begin()+i);
+		ports[p].inputBufferCount--;
+		if(queue.size()==0)
+		{
+			portsWithRequests[linkBusID].Clear(p);
+		}
+		UpdatePortLoad(p);
+		return true;
+	}
+
+	return false;
+}
+
+//Hands a request that has crossed link bus link over to its channel
+void BOB::DeliverToChannel(Transaction *trans, unsigned link)
+{
+	unsigned chan = trans->mappedChannel;
+
+	//channels further down a daisy chain are reached through the buffers in front of them
+	if(channelHop[chan]>0)
+	{
+		unsigned packetBytes;
+		switch(trans->transactionType)
+		{
+		case DATA_READ:
+			packetBytes = RD_REQUEST_PACKET_OVERHEAD;
+			break;
+		case DATA_WRITE:
+			packetBytes = WR_REQUEST_PACKET_OVERHEAD + TRANSACTION_SIZE;
+			break;
+		default:
+			packetBytes = trans->transactionSize;
+			break;
+		}
+
+		forwardedRequests[chan].push_back(make_pair(ForwardThroughHops(chan, packetBytes, true), trans));
+		return;
+	}
+
+	AddToChannel(trans, link);
+}
+
+//Hands a request to its channel's simple controller
+void BOB::AddToChannel(Transaction *trans, unsigned link)
+{
+	//compute total time in serDes and travel up channel
+	trans->cyclesReqLink = currentClockCycle - trans->cyclesReqLink;
+	if(DEBUG_BOB) DEBUG("  == Adding to channel "<<trans->mappedChannel<<" (from link bus "<<link<<") : "<<*trans);
+
+	//reset again when the ACTIVATE goes out (reads answered from the work queue never send one)
+	trans->dramStartTime = currentClockCycle;
+
+	//add to channel
+	requestsInTransit[trans->mappedChannel]--;
+	if(trans->transactionType==LOGIC_OPERATION)
+	{
+		logicOpsInTransit[trans->mappedChannel]--;
+	}
+	channels[trans->mappedChannel]->AddTransaction(trans, 0); //0 is not used
+}
+
+//Reserves each hop between the first buffer on chan's link bus and chan's buffer, in the
+//  order a request or response crosses them, and returns the cycle the packet gets through
+uint64_t BOB::ForwardThroughHops(unsigned chan, unsigned packetBytes, bool request)
+{
+	unsigned link = channelLink[chan];
+	unsigned hops = channelHop[chan];
+	uint64_t time = currentClockCycle;
+
+	for(unsigned h=0; h<hops; h++)
+	{
+		//requests head away from the link bus, responses toward it
+		unsigned hop = request ? h+1 : hops-h;
+		uint64_t &freeAt = request ? hopRequestFree[link][hop] : hopResponseFree[link][hop];
+		unsigned cycles = LinkBusCycles(packetBytes, request ? hopRequestLanes[link][hop] : hopResponseLanes[link][hop], 1);
+
+		time = max(time, freeAt);
+		freeAt = time + cycles;
+		time += cycles + hopLatency[link][hop];
+
+		if(request) hopRequestBusy[link][hop] += cycles;
+		else hopResponseBusy[link][hop] += cycles;
+	}
+
+	return time;
+}
+
+//Delivers requests which have been forwarded to their channel and forwards responses
+//  toward the first buffer so they are ready to go out on the link bus
+void BOB::UpdateDaisyChains()
+{
+	for(unsigned i=0; i<forwardedChannels.size(); i++)
+	{
+		unsigned chan = forwardedChannels[i];
+		unsigned link = channelLink[chan];
+
+		while(forwardedRequests[chan].size()>0 &&
+		        forwardedRequests[chan][0].first<=currentClockCycle)
+		{
+			AddToChannel(forwardedRequests[chan][0].second, link);
+			forwardedRequests[chan].pop_front();
+		}
+
+		//responses still at the channel - the one on the link bus stays in the return queue until it is across
+		unsigned responses = channels[chan]->readReturnQueue.size() + (channels[chan]->pendingLogicResponse!=NULL);
+		if(inFlightResponseLink[link]!=NULL &&
+		        inFlightResponseLink[link]->mappedChannel==chan &&
+		        inFlightResponseLink[link]->transactionType==RETURN_DATA)
+		{
+			responses--;
+		}
+
+		while(forwardedResponses[chan].size()<min(responses, DAISY_CHAIN_FORWARD_DEPTH))
+		{
+			//data goes out before any logic response queued behind it
+			unsigned packetBytes = forwardedResponses[chan].size()<channels[chan]->readReturnQueue.size() ?
+			                       RD_RESPONSE_PACKET_OVERHEAD + TRANSACTION_SIZE : LogicResponseSize(channels[chan]->pendingLogicResponse);
+			forwardedResponses[chan].push_back(ForwardThroughHops(chan, packetBytes, false));
+		}
+	}
+}
+
+//Returns how many bytes of data a write or read response carries across a link bus.
+//  If compression is on and the transaction does not already have a compressed size,
+//  one is drawn from the configured distribution.
+unsigned BOB::LinkPayloadSize(Transaction *trans)
+{
+	if(!ENABLE_LINK_COMPRESSION)
+	{
+		return TRANSACTION_SIZE;
+	}
+
+	if(trans->compressedSize==0)
+	{
+		if((unsigned)(rand_r(&compressionSeed) % 100) < COMPRESSION_ZERO_LINE_PERCENT)
+		{
+			trans->compressedSize = COMPRESSED_ZERO_LINE_SIZE;
+		}
+		else
+		{
+			trans->compressedSize = COMPRESSED_MIN_SIZE +
+			                        rand_r(&compressionSeed) % (COMPRESSED_MAX_SIZE - COMPRESSED_MIN_SIZE + 1);
+		}
+	}
+
+	//compression never makes the data bigger
+	return min(max(trans->compressedSize, 1u), TRANSACTION_SIZE);
+}
+
+//Number of bytes a logic response takes on a link bus - the header plus any result it carries
+unsigned BOB::LogicResponseSize(Transaction *trans)
+{
+	if(trans==NULL || trans->logicOpContents==NULL)
+	{
+		return LOGIC_RESPONSE_PACKET_OVERHEAD;
+	}
+	return LOGIC_RESPONSE_PACKET_OVERHEAD + ((LogicOperation *)trans->logicOpContents)->resultSize;
+}
+
+//Cycles a logic response keeps a port busy - one, or enough to move the result it carries
+unsigned BOB::LogicResponsePortCycles(Transaction *trans)
+{
+	unsigned resultBytes = LogicResponseSize(trans) - LOGIC_RESPONSE_PACKET_OVERHEAD;
+	return max(1u, resultBytes / PORT_WIDTH + !!(resultBytes % PORT_WIDTH));
+}
+
+//Returns the response that channel chan would put on its link bus next, or NULL if
+//  it has nothing ready
+Transaction *BOB::ResponseCandidate(unsigned chan)
+{
+	//responses from further down a daisy chain have to reach the first buffer before they can go
+	if(channelHop[chan]>0 &&
+	        (forwardedResponses[chan].empty() || forwardedResponses[chan][0]>currentClockCycle))
+	{
+		return NULL;
+	}
+
+	if(channels[chan]->pendingLogicResponse!=NULL)
+	{
+		return channels[chan]->pendingLogicResponse;
+	}
+	else if(channels[chan]->readReturnQueue.size()>0)
+	{
+		for(unsigned p=0; p<pendingReads.size(); p++)
+		{
+			if(pendingReads[p]->transactionID == channels[chan]->readReturnQueue[0]->transactionID)
+			{
+				return pendingReads[p];
+			}
+		}
+	}
+
+	return NULL;
+}
+
+//Picks which channel on a link bus sends the next response according to responseArbitration.
+//  Channels are visited starting at the round-robin pointer so ties go to the next channel in line.
+bool BOB::SelectResponseChannel(unsigned link, unsigned &chosenChannel)
+{
+	Transaction *best = NULL;
+	unsigned bestChannel = 0;
+
+	for(unsigned z=0; z<linkChannels[link].size(); z++)
+	{
+		unsigned chan = linkChannels[link][(responseLinkRoundRobin[link] + z) % linkChannels[link].size()];
+		Transaction *candidate = ResponseCandidate(chan);
+		if(candidate==NULL) continue;
+
+		if(best==NULL)
+		{
+			best = candidate;
+			bestChannel = chan;
+			//plain round robin takes the first channel that has something
+			if(responseArbitration==RSP_ROUND_ROBIN) break;
+			continue;
+		}
+
+		bool better = false;
+		switch(responseArbitration)
+		{
+		case RSP_OLDEST_FIRST:
+			better = candidate->fullStartTime < best->fullStartTime;
+			break;
+		case RSP_RRQ_OCCUPANCY:
+			better = channels[chan]->readReturnQueue.size() > channels[bestChannel]->readReturnQueue.size();
+			break;
+		case RSP_PRIORITY_CLASS:
+		{
+			unsigned candidateClass = min(candidate->coreID / CORES_PER_PRIORITY_CLASS, NUM_PRIORITY_CLASSES-1);
+			unsigned bestClass = min(best->coreID / CORES_PER_PRIORITY_CLASS, NUM_PRIORITY_CLASSES-1);
+			better = candidateClass < bestClass ||
+			         (candidateClass == bestClass && candidate->fullStartTime < best->fullStartTime);
+			break;
+		}
+		default:
+			break;
+		}
+
+		if(better)
+		{
+			best = candidate;
+			bestChannel = chan;
+		}
+	}
+
+	chosenChannel = bestChannel;
+	return best!=NULL;
+}
+
+//Number of lanes currently turned on in each direction of a link bus
+unsigned BOB::RequestLinkWidth(unsigned link)
+{
+	return max(requestLinkLanes[link] >> linkLaneShift[link], 1u);
+}
+
+unsigned BOB::ResponseLinkWidth(unsigned link)
+{
+	return max(responseLinkLanes[link] >> linkLaneShift[link], 1u);
+}
+
+//New packets may not start on a link bus that is retraining or waiting to retrain
+bool BOB::LinkAvailable(unsigned link)
+{
+	return linkReconfigCountdown[link]==0 &&
+	       targetLaneShift[link]==linkLaneShift[link] &&
+	       targetClockDivider[link]==linkClockDivider[link] &&
+	       targetRequestLanes[link]==requestLinkLanes[link];
+}
+
+//Link governor - every LINK_GOVERNOR_INTERVAL cycles each link bus picks new lane and clock
+//  settings based on how busy it was. Changes wait for the link to empty and then hold the
+//  link for LINK_RECONFIG_LATENCY (or LANE_SWITCH_LATENCY if lanes change direction) cycles.
+void BOB::UpdateLinkConfiguration()
+{
+	for(unsigned l=0; l<NUM_LINK_BUSES; l++)
+	{
+		if(linkReconfigCountdown[l]>0)
+		{
+			linkReconfigCountdown[l]--;
+			linkReconfigCycles[l]++;
+		}
+
+		//apply a pending change once nothing is on the link
+		if(!LinkAvailable(l) && linkReconfigCountdown[l]==0 &&
+		        inFlightRequestLink[l]==NULL && inFlightResponseLink[l]==NULL)
+		{
+			if(targetRequestLanes[l]!=requestLinkLanes[l])
+			{
+				//the total number of lanes on the link stays the same
+				responseLinkLanes[l] = requestLinkLanes[l] + responseLinkLanes[l] - targetRequestLanes[l];
+				requestLinkLanes[l] = targetRequestLanes[l];
+				linkReconfigCountdown[l] = LANE_SWITCH_LATENCY;
+				laneSwitches[l]++;
+			}
+			if(targetLaneShift[l]!=linkLaneShift[l] || targetClockDivider[l]!=linkClockDivider[l])
+			{
+				linkLaneShift[l] = targetLaneShift[l];
+				linkClockDivider[l] = targetClockDivider[l];
+				linkReconfigCountdown[l] = max(linkReconfigCountdown[l], LINK_RECONFIG_LATENCY);
+				linkReconfigs[l]++;
+			}
+			if(DEBUG_BOB) DEBUG("  == Link Bus "<<l<<" retraining to "<<RequestLinkWidth(l)<<"/"<<ResponseLinkWidth(l)<<" lanes at 1/"<<linkClockDivider[l]<<" clock");
+		}
+	}
+
+	if((!ENABLE_LINK_DVFS && !ENABLE_LANE_REBALANCING) ||
+	        currentClockCycle==0 || currentClockCycle % LINK_GOVERNOR_INTERVAL!=0) return;
+
+	for(unsigned l=0; l<NUM_LINK_BUSES; l++)
+	{
+		float requestUtilization = (float)requestLinkBusyInterval[l] / LINK_GOVERNOR_INTERVAL;
+		float responseUtilization = (float)responseLinkBusyInterval[l] / LINK_GOVERNOR_INTERVAL;
+		float utilization = max(requestUtilization, responseUtilization);
+		requestLinkBusyInterval[l]=0;
+		responseLinkBusyInterval[l]=0;
+
+		//don't stack changes on top of one that hasn't happened yet
+		if(!LinkAvailable(l)) continue;
+
+		//move lanes toward whichever direction is busier, but only if the busier direction is
+		//  expected to still be the busier one afterwards by less than it is now
+		if(ENABLE_LANE_REBALANCING)
+		{
+			unsigned req = requestLinkLanes[l];
+			unsigned rsp = responseLinkLanes[l];
+			unsigned step = LANE_REBALANCE_STEP;
+			if(requestUtilization > responseUtilization &&
+			        rsp >= LANE_REBALANCE_MIN_LANES + step &&
+			        max(requestUtilization * req / (req + step), responseUtilization * rsp / (rsp - step)) <
+			        requestUtilization - LANE_REBALANCE_HYSTERESIS)
+			{
+				targetRequestLanes[l] = req + step;
+			}
+			else if(responseUtilization > requestUtilization &&
+			        req >= LANE_REBALANCE_MIN_LANES + step &&
+			        max(requestUtilization * req / (req - step), responseUtilization * rsp / (rsp + step)) <
+			        responseUtilization - LANE_REBALANCE_HYSTERESIS)
+			{
+				targetRequestLanes[l] = req - step;
+			}
+		}
+
+		if(!ENABLE_LINK_DVFS) continue;
+
+		if(utilization < LINK_DVFS_LOW_UTILIZATION)
+		{
+			//drop lanes first, then slow down the clock
+			if(linkLaneShift[l] < LINK_DVFS_MAX_LANE_SHIFT)
+			{
+				targetLaneShift[l]++;
+			}
+			else if(linkClockDivider[l]*2 <= LINK_DVFS_MAX_CLOCK_DIVIDER)
+			{
+				targetClockDivider[l]*=2;
+			}
+		}
+		else if(utilization > LINK_DVFS_HIGH_UTILIZATION)
+		{
+			//undo in the opposite order
+			if(linkClockDivider[l] > 1)
+			{
+				targetClockDivider[l]/=2;
+			}
+			else if(linkLaneShift[l] > 0)
+			{
+				targetLaneShift[l]--;
+			}
+		}
+	}
+}
+
+//Computes how many CPU cycles a packet occupies a link bus with the given number of lanes
+//  running at the link clock divided by clockDivider
+unsigned BOB::LinkBusCycles(unsigned packetBytes, unsigned linkBusWidth, unsigned clockDivider)
+{
+	//
+	//widths are in bits
+	//
+	unsigned totalChannelCycles = (packetBytes * 8) / linkBusWidth +
+	                              !!((packetBytes * 8) % linkBusWidth);
+
+	//a slower link clock stretches each transfer
+	totalChannelCycles *= clockDivider;
+
+	//if the channel uses DDR signaling, the cycles is cut in half
+	if(LINK_BUS_USE_DDR)
+	{
+		totalChannelCycles = totalChannelCycles / 2 + !!(totalChannelCycles % 2);
+	}
+
+	//since the channel is faster than the CPU, figure out how many CPU
+	//  cycles the channel will be in use
+	return (totalChannelCycles / LINK_CPU_CLK_RATIO) +
+	       !!(totalChannelCycles % LINK_CPU_CLK_RATIO);
+}
+
+//A logic layer wrote the line holding address - buffered copies of it are stale
+void BOB::LogicWrite(uint64_t address, unsigned notused)
+{
+	if(ENABLE_READ_BUFFER)
+	{
+		readBuffer.Invalidate(address, currentClockCycle);
+	}
+}
+
+//Lets a logic layer find the channel an address lives in
+unsigned BOB::LogicChannelOf(uint64_t address, unsigned)
+{
+	return FindChannelID(address);
+}
+
+//Lets a logic layer get at the logic layer of the channel an address lives in
+LogicLayerInterface *BOB::LogicLayerOf(uint64_t address, unsigned)
+{
+	return channels[FindChannelID(address)]->logicLayer;
+}
+
+//Moves data logic layers send to other channels over the side-band path
+void BOB::UpdateLogicTransfers()
+{
+	//hand over data that made it across - if the destination is full it waits at the head of the path
+	while(logicTransfers.size()>0 && logicTransfers[0].arrivalCycle<=currentClockCycle)
+	{
+		LogicTransfer &transfer = logicTransfers[0];
+		unsigned transactionID = transfer.data->transactionID;
+		TransactionType type = transfer.data->transactionType;
+		LogicLayerInterface *destination = channels[transfer.data->mappedChannel]->logicLayer;
+
+		if(type==RETURN_DATA)
+		{
+			//data for a read the source made in another channel
+			destination->ReceiveLogicOperation(transfer.data,0);
+		}
+		else
+		{
+			//the channel frees writes it takes
+			if(!channels[transfer.data->mappedChannel]->AddTransaction(transfer.data,0))
+			{
+				break;
+			}
+
+			//a read's data is sent back to the logic layer that asked for it
+			if(type==DATA_READ)
+			{
+				destination->remoteReads[transactionID] = transfer.sourceChannel;
+			}
+			else
+			{
+				channels[transfer.sourceChannel]->logicLayer->TransferComplete(transactionID);
+			}
+		}
+
+		if(DEBUG_LOGIC) DEBUG("== Logic data T"<<transactionID<<" from channel "<<transfer.sourceChannel<<" delivered on cycle "<<currentClockCycle);
+		logicTransfersDone++;
+		logicTransferLatency += currentClockCycle - transfer.sendCycle;
+		logicTransfers.pop_front();
+	}
+
+	if(logicTransferCountdown>0)
+	{
+		logicTransferCountdown--;
+		logicTransferBusy++;
+		return;
+	}
+
+	//round-robin among the logic layers with data to send
+	for(unsigned i=0; i<NUM_CHANNELS; i++)
+	{
+		unsigned source = (logicTransferRoundRobin + i) % NUM_CHANNELS;
+		deque<Transaction *> &queue = channels[source]->logicLayer->transferQueue;
+		if(queue.empty()) continue;
+
+		LogicTransfer transfer;
+		transfer.data = queue.front();
+		//returned data already knows which channel asked for it
+		if(transfer.data->transactionType!=RETURN_DATA)
+		{
+			transfer.data->mappedChannel = FindChannelID(transfer.data->address);
+		}
+		transfer.sourceChannel = source;
+		transfer.sendCycle = currentClockCycle;
+		queue.pop_front();
+
+		//data crosses every buffer between the two channels - through the main controller
+		//  if they hang off different link buses
+		unsigned destination = transfer.data->mappedChannel;
+		unsigned hopCycles = 0;
+		if(channelLink[source]==channelLink[destination])
+		{
+			unsigned first = min(channelHop[source], channelHop[destination]);
+			unsigned last = max(channelHop[source], channelHop[destination]);
+			for(unsigned h=first+1; h<=last; h++)
+			{
+				hopCycles += hopLatency[channelLink[source]][h];
+			}
+		}
+		else
+		{
+			for(unsigned h=1; h<=channelHop[source]; h++)
+			{
+				hopCycles += hopLatency[channelLink[source]][h];
+			}
+			for(unsigned h=1; h<=channelHop[destination]; h++)
+			{
+				hopCycles += hopLatency[channelLink[destination]][h];
+			}
+		}
+
+		unsigned packetBytes;
+		switch(transfer.data->transactionType)
+		{
+		case DATA_READ:
+			packetBytes = RD_REQUEST_PACKET_OVERHEAD;
+			break;
+		case RETURN_DATA:
+			packetBytes = RD_RESPONSE_PACKET_OVERHEAD + transfer.data->transactionSize;
+			break;
+		default:
+			packetBytes = WR_REQUEST_PACKET_OVERHEAD + transfer.data->transactionSize;
+			break;
+		}
+		logicTransferCountdown = packetBytes / LOGIC_TRANSFER_WIDTH + !!(packetBytes % LOGIC_TRANSFER_WIDTH);
+		transfer.arrivalCycle = currentClockCycle + logicTransferCountdown + LOGIC_TRANSFER_LATENCY + hopCycles;
+		logicTransferBytes += packetBytes;
+		logicTransfers.push_back(transfer);
+
+		if(DEBUG_LOGIC) DEBUG("== Logic data "<<*transfer.data<<" leaving channel "<<source<<" for channel "<<destination<<" on cycle "<<currentClockCycle);
+
+		logicTransferRoundRobin = (source + 1) % NUM_CHANNELS;
+		break;
+	}
+}
+
+unsigned BOB::FindChannelID(Transaction* trans)
+{
+	if(DEBUG_BOB) DEBUGN("    == Mapping "<<*trans);
+	unsigned channelID = FindChannelID(trans->address);
+	if(DEBUG_BOB) DEBUG(" to channel "<<channelID);
+	return channelID;
+}
+
+unsigned BOB::FindChannelID(uint64_t address)
+{
+	unsigned channelID = 0;
+	unsigned bitWidth = log2(NUM_CHANNELS);
+	uint64_t channelMask = 0;
+	unsigned channelIDOffset;// = log2(BUS_ALIGNMENT_SIZE) + CHANNEL_ID_OFFSET;
+
+	switch(mappingScheme)
+	{
+	case BK_CLH_RW_RK_CH_CLL_BY://bank:col_high:row:rank:chan:col_low:by
+		channelIDOffset = cacheOffset;//bus alignment + column low bits should make the cache offset
+		break;
+	case CLH_RW_RK_BK_CH_CLL_BY://col_high:row:rank:bank:chan:col_low:byte
+		channelIDOffset = cacheOffset;//bus alignment + column low bits should make the cache offset
+		break;
+	case RK_BK_RW_CLH_CH_CLL_BY://rank:bank:row:col_high:chan:col_low:by
+		channelIDOffset = cacheOffset;//bus alignment + column low bits should make the cache offset
+		break;
+	case RW_BK_RK_CH_CL_BY://row:bank:rank:chan:col:byte
+		channelIDOffset = colBitWidth + busOffsetBitWidth;
+		break;
+	case RW_CH_BK_RK_CL_BY://row:chan:bank:rank:col:byte
+		channelIDOffset = busOffsetBitWidth + colBitWidth + rankBitWidth + bankBitWidth;
+		break;
+	case RW_BK_RK_CLH_CH_CLL_BY://row:bank:rank:col_high:chan:col_low:byte
+		channelIDOffset = cacheOffset; //bus alignment + column low bits should make the cache offset
 		break;
 	case RW_CLH_BK_RK_CH_CLL_BY://row:col_high:bank:rank:chan:col_low:byte
 		channelIDOffset = cacheOffset;
@@ -810,8 +1858,6 @@ unsigned BOB::FindChannelID(Transaction* trans)
 		break;
 	};
 
-	if(DEBUG_BOB) DEBUGN("    == Mapping "<<*trans);
-
 	//build channel id mask
 	for(unsigned i=0; i<bitWidth; i++)
 	{
@@ -820,9 +1866,8 @@ unsigned BOB::FindChannelID(Transaction* trans)
 	}
 
 	channelMask = channelMask << channelIDOffset;
-	channelID = (trans->address & channelMask) >> channelIDOffset;
+	channelID = (address & channelMask) >> channelIDOffset;
 
-	if(DEBUG_BOB) DEBUG(" to channel "<<channelID);
 	return channelID;
 }
 
@@ -861,7 +1906,8 @@ void BOB::PrintStats(ofstream &statsOut, ofstream &powerOut, bool finalPrint, un
 	PRINT(" == Ports");
 	for(unsigned p=0; p<NUM_PORTS; p++)
 	{
-		PRINT("  -- Port "<<p<<" - inputBufferAvg : "<<(float)portInputBufferAvg[p]/elapsedCycles<<" ("<<ports[p].inputBuffer.size()<<")   outputBufferAvg : "<<(float)portOutputBufferAvg[p]/elapsedCycles<<" ("<<ports[p].outputBuffer.size()<<")");
+		UpdatePortOccupancy(p);
+		PRINT("  -- Port "<<p<<" - inputBufferAvg : "<<(float)portInputBufferAvg[p]/elapsedCycles<<" ("<<ports[p].inputBufferCount<<")   outputBufferAvg : "<<(float)portOutputBufferAvg[p]/elapsedCycles<<" ("<<ports[p].outputBuffer.size()<<")");
 		portInputBufferAvg[p]=0;
 		portOutputBufferAvg[p]=0;
 	}
@@ -906,9 +1952,121 @@ void BOB::PrintStats(ofstream &statsOut, ofstream &powerOut, bool finalPrint, un
 	PRINT("     -----------");
 	PRINT("      "<<reqtotal/NUM_LINK_BUSES<<"          "<<rsptotal/NUM_LINK_BUSES<<" (avgs)");
 
+	PRINT(" == Request Coalescing (up to "<<REQUEST_COALESCING_MAX<<" reads per packet)");
+	PRINT("      readPkts     reads   factor   reqBytes  effBW(GB/s)");
+	for(unsigned l=0; l<NUM_LINK_BUSES; l++)
+	{
+		//effective bandwidth is what the link would have needed to carry the same requests one per packet
+		snprintf(tmp_str, MAX_TMP_STR, "%d]%10d%10d%9.3f%11ld%13.4f\n",
+		         l,
+		         requestLinkReadPackets[l],
+		         requestLinkReads[l],
+		         requestLinkReadPackets[l]==0 ? 0.0 : (float)requestLinkReads[l]/requestLinkReadPackets[l],
+		         requestLinkBytes[l],
+		         requestLinkEquivalentBytes[l]/(elapsedCycles*CPU_CLK_PERIOD));
+		PRINTN(tmp_str);
+
+		requestLinkReadPackets[l]=0;
+		requestLinkReads[l]=0;
+		requestLinkEquivalentBytes[l]=0;
+	}
+
+	if(ENABLE_LINK_COMPRESSION)
+	{
+		PRINT(" == Link Compression (adds "<<(COMPRESSOR_LATENCY+DECOMPRESSOR_LATENCY)*CPU_CLK_PERIOD<<" ns to each compressed packet)");
+		PRINT("      reqData -> compressed   gain      rspData -> compressed   gain    packets");
+		for(unsigned l=0; l<NUM_LINK_BUSES; l++)
+		{
+			snprintf(tmp_str, MAX_TMP_STR, "%d]%11ld%13ld%7.3f%15ld%13ld%7.3f%11d\n",
+			         l,
+			         requestPayloadBytes[l],
+			         requestCompressedBytes[l],
+			         requestCompressedBytes[l]==0 ? 0.0 : (float)requestPayloadBytes[l]/requestCompressedBytes[l],
+			         responsePayloadBytes[l],
+			         responseCompressedBytes[l],
+			         responseCompressedBytes[l]==0 ? 0.0 : (float)responsePayloadBytes[l]/responseCompressedBytes[l],
+			         compressedPackets[l]);
+			PRINTN(tmp_str);
+		}
+	}
+	for(unsigned l=0; l<NUM_LINK_BUSES; l++)
+	{
+		requestPayloadBytes[l]=0;
+		requestCompressedBytes[l]=0;
+		responsePayloadBytes[l]=0;
+		responseCompressedBytes[l]=0;
+		compressedPackets[l]=0;
+	}
+
+	if(ENABLE_READ_BUFFER)
+	{
+		PRINT(" == Read Buffer ("<<READ_BUFFER_SIZE/1024<<"KB, "<<READ_BUFFER_ASSOCIATIVITY<<"-way, "<<(READ_BUFFER_WRITE_THROUGH ? "write-through" : "write-invalidate")<<")");
+		float hitLatency = readBuffer.hits==0 ? 0 : (float)readBufferHitLatency/readBuffer.hits;
+		float missLatency = readBufferMisses==0 ? 0 : (float)readBufferMissLatency/readBufferMisses;
+		PRINT("    -- Lookups : "<<readBuffer.lookups<<"   Hits : "<<readBuffer.hits<<
+		      " ("<<(readBuffer.lookups==0 ? 0 : (float)readBuffer.hits/readBuffer.lookups*100.0)<<"%)"<<
+		      "   Fills : "<<readBuffer.fills<<"   Evictions : "<<readBuffer.evictions<<"   Write hits : "<<readBuffer.writeHits);
+		PRINT("    -- Latency to port (hit/miss) : "<<hitLatency*CPU_CLK_PERIOD<<"/"<<missLatency*CPU_CLK_PERIOD<<" ns"<<
+		      "   saved : "<<(missLatency>hitLatency ? (missLatency-hitLatency)*CPU_CLK_PERIOD : 0)<<" ns per hit");
+		//each hit keeps a read request and its response off the link buses
+		PRINT("    -- Link bandwidth saved : "<<(float)readBuffer.hits*(RD_REQUEST_PACKET_OVERHEAD+RD_RESPONSE_PACKET_OVERHEAD+TRANSACTION_SIZE)/(elapsedCycles*CPU_CLK_PERIOD)<<" GB/s");
+
+		readBuffer.lookups=0;
+		readBuffer.hits=0;
+		readBuffer.fills=0;
+		readBuffer.evictions=0;
+		readBuffer.writeHits=0;
+		readBufferHitLatency=0;
+		readBufferMissLatency=0;
+		readBufferMisses=0;
+
+		//only writes newer than the oldest read still out can keep a fill from happening
+		uint64_t oldestRead = currentClockCycle;
+		for(unsigned i=0; i<pendingReads.size(); i++)
+		{
+			oldestRead = min(oldestRead, pendingReads[i]->fullStartTime);
+		}
+		readBuffer.ForgetWritesBefore(oldestRead);
+	}
+
+	if(ENABLE_READ_COALESCING)
+	{
+		PRINT(" == Duplicate Read Coalescing (max "<<READ_COALESCING_MAX_WAITERS<<" waiters per read)");
+		PRINT("    -- Reads coalesced : "<<readsCoalesced<<"   Waiter limit hits : "<<readWaitersFull<<
+		      "   Lines outstanding : "<<outstandingReadLines.size());
+		readsCoalesced=0;
+		readWaitersFull=0;
+	}
+
+	PRINT(" == SerDes Buffer Occupancy (depth "<<SERDES_BUFFER_DEPTH<<")");
+	PRINT("      Req Avg (Max)        Rsp Avg (Max)");
+	for(unsigned l=0; l<NUM_LINK_BUSES; l++)
+	{
+		PRINT("   "<<l<<"] "<<(float)serDesRequestOccupancy[l]/elapsedCycles<<" ("<<serDesRequestMax[l]<<")            "<<(float)serDesResponseOccupancy[l]/elapsedCycles<<" ("<<serDesResponseMax[l]<<")");
+		serDesRequestOccupancy[l]=0;
+		serDesResponseOccupancy[l]=0;
+		serDesRequestMax[l]=0;
+		serDesResponseMax[l]=0;
+	}
+
+	if(forwardedChannels.size()>0)
+	{
+		PRINT(" == Daisy Chain Hops (utilization req/rsp)");
+		for(unsigned l=0; l<NUM_LINK_BUSES; l++)
+		{
+			for(unsigned h=1; h<hopLatency[l].size(); h++)
+			{
+				PRINT("    -- Link Bus "<<l<<" hop "<<h<<" ("<<hopLatency[l][h]*CPU_CLK_PERIOD<<" ns, "<<hopRequestLanes[l][h]<<"/"<<hopResponseLanes[l][h]<<" lanes) : "<<
+				      (float)hopRequestBusy[l][h]/elapsedCycles*100.0<<"% / "<<(float)hopResponseBusy[l][h]/elapsedCycles*100.0<<"%");
+				hopRequestBusy[l][h]=0;
+				hopResponseBusy[l][h]=0;
+			}
+		}
+	}
+
 
 	PRINT(" == Channel Usage and Stats ("<<(NUM_RANKS * gigabytesPerRank)<<"GB/Chan == "<<NUM_RANKS * gigabytesPerRank * NUM_CHANNELS<<" GB total)");
-	PRINT("     reqs   workQAvg  workQMax idleBanks   actBanks  preBanks  refBanks  (totalBanks) BusIdle  BW("<<bw<<")  RRQMax("<<CHANNEL_RETURN_Q_MAX/TRANSACTION_SIZE<<")   RRQFull lifetimeRequests");
+	PRINT("     reqs   workQAvg  workQMax idleBanks   actBanks  preBanks  refBanks  (totalBanks) BusIdle  BW("<<bw<<")  RRQMax("<<CHANNEL_RETURN_Q_MAX/TRANSACTION_SIZE<<")  RRQRdStall RRQWrStall lifetimeRequests");
 	float totalDRAMbw = 0;
 	for(unsigned i=0; i<NUM_CHANNELS; i++)
 	{
@@ -922,7 +2080,7 @@ void BOB::PrintStats(ofstream &statsOut, ofstream &powerOut, bool finalPrint, un
 		channelCountersLifetime[i]+=channelCounters[i];
 
 		// since trying to actually format strings with stream operators is a huge pain
-		snprintf(tmp_str, MAX_TMP_STR, "%d]%9d%10.4f%10d%10.4f%10.4f%10.4f%10.4f%10.4f%10.2f%10.3f%10d(%d)%10d%10ld\n",
+		snprintf(tmp_str, MAX_TMP_STR, "%d]%9d%10.4f%10d%10.4f%10.4f%10.4f%10.4f%10.4f%10.2f%10.3f%10d(%d)%10d%10d%10ld\n",
 		         i,
 		         channelCounters[i],
 		         (float)channels[i]->simpleController.commandQueueAverage/dramCyclesElapsed,
@@ -939,7 +2097,8 @@ void BOB::PrintStats(ofstream &statsOut, ofstream &powerOut, bool finalPrint, un
 		         DRAMBandwidth,
 		         channels[i]->readReturnQueueMax,
 		         (int)channels[i]->readReturnQueue.size(),
-		         channels[i]->simpleController.RRQFull,
+		         channels[i]->simpleController.RRQFullReadStalls,
+		         channels[i]->simpleController.RRQFullWriteStalls,
 		         channelCountersLifetime[i]
 
 		        );
@@ -962,7 +2121,8 @@ void BOB::PrintStats(ofstream &statsOut, ofstream &powerOut, bool finalPrint, un
 		channels[i]->readReturnQueueMax=0;
 		channels[i]->DRAMBusIdleCount=0;
 		channelCounters[i]=0;
-		channels[i]->simpleController.RRQFull=0;
+		channels[i]->simpleController.RRQFullReadStalls=0;
+		channels[i]->simpleController.RRQFullWriteStalls=0;
 		cmdQFull[i]=0;
 
 		PRINTN(tmp_str);
@@ -972,10 +2132,188 @@ void BOB::PrintStats(ofstream &statsOut, ofstream &powerOut, bool finalPrint, un
 	statsOut<<";";
 
 	PRINT("                                                                                          AVG : "<<totalDRAMbw/NUM_CHANNELS);
+
+	const char *arbitrationNames[] = {"round robin", "oldest first", "RRQ occupancy", "priority class"};
+	PRINT(" == Return Queue Wait ("<<arbitrationNames[responseArbitration]<<" arbitration, "<<RESPONSE_WAIT_HISTOGRAM_BIN_SIZE<<" cycle bins)");
+	for(unsigned i=0; i<NUM_CHANNELS; i++)
+	{
+		PRINTN("  "<<i<<"]");
+		for(unsigned b=0; b<RESPONSE_WAIT_HISTOGRAM_BINS; b++)
+		{
+			PRINTN(" "<<responseWaitHistogram[i][b]);
+			responseWaitHistogram[i][b]=0;
+		}
+		PRINT("   max : "<<responseWaitMax[i]);
+		responseWaitMax[i]=0;
+	}
 	PRINT(" == Requests seen at Channels");
 	PRINT("  -- Reads  : "<<readCounter);
 	PRINT("  -- Writes : "<<writeCounter);
 	PRINT("            = "<<totalRequestsAtChannels);
+	if(ENABLE_WRITE_COMBINING)
+	{
+		PRINT(" == Write Combining");
+		for(unsigned i=0; i<NUM_CHANNELS; i++)
+		{
+			PRINT("  -- Channel "<<i<<" - writes combined : "<<channels[i]->simpleController.writesCombined<<"   reads forwarded : "<<channels[i]->simpleController.readsForwarded);
+			channels[i]->simpleController.writesCombined = 0;
+			channels[i]->simpleController.readsForwarded = 0;
+		}
+	}
+	if(ENABLE_PREFETCHING)
+	{
+		PRINT(" == Prefetching ("<<PREFETCH_DEGREE<<" lines ahead, "<<PREFETCH_BUFFER_ENTRIES<<" line buffer)");
+		PRINT("     issued    useful(late)    unused   accuracy   coverage   overhead(GB/s)");
+		for(unsigned i=0; i<NUM_CHANNELS; i++)
+		{
+			DRAMChannel *chan = channels[i];
+			unsigned issued = chan->simpleController.prefetchesIssued;
+			unsigned useful = chan->prefetchHits + chan->prefetchLateHits;
+			//accuracy is useful prefetches over the ones that were issued, coverage is demand reads they answered
+			PRINT("  "<<i<<"] "<<setw(8)<<issued<<"  "<<setw(8)<<useful<<"("<<chan->prefetchLateHits<<")  "<<setw(8)<<chan->prefetchesUnused<<
+			      "   "<<setw(7)<<(issued==0 ? 0 : (float)useful/issued*100.0)<<"%  "<<setw(7)<<(chan->demandReads==0 ? 0 : (float)useful/chan->demandReads*100.0)<<"%  "<<
+			      setw(8)<<(float)issued*TRANSACTION_SIZE/(elapsedCycles*CPU_CLK_PERIOD));
+			chan->simpleController.prefetchesIssued = 0;
+			chan->prefetchHits = 0;
+			chan->prefetchLateHits = 0;
+			chan->prefetchesUnused = 0;
+			chan->demandReads = 0;
+		}
+	}
+
+	unsigned remoteReads = 0;
+	for(unsigned i=0; i<NUM_CHANNELS; i++)
+	{
+		remoteReads += channels[i]->logicLayer->remoteReadsSent;
+		channels[i]->logicLayer->remoteReadsSent = 0;
+	}
+	if(logicTransferBytes>0 || logicTransfers.size()>0)
+	{
+		PRINT(" == Logic Data Transfers (side-band "<<LOGIC_TRANSFER_WIDTH<<" B/cycle)");
+		PRINT("    -- Transfers : "<<logicTransfersDone<<"   In flight : "<<logicTransfers.size()<<
+		      "   Reads from other channels : "<<remoteReads<<
+		      "   Bandwidth : "<<(float)logicTransferBytes/(elapsedCycles*CPU_CLK_PERIOD)<<" GB/s"<<
+		      "   Utilization : "<<(float)logicTransferBusy/elapsedCycles*100.0<<"%"<<
+		      "   Avg latency : "<<(logicTransfersDone==0 ? 0 : (float)logicTransferLatency/logicTransfersDone*CPU_CLK_PERIOD)<<" ns");
+		logicTransfersDone = 0;
+		logicTransferLatency = 0;
+		logicTransferBytes = 0;
+		logicTransferBusy = 0;
+	}
+
+	//only shown when some logic layer did work this epoch
+	bool logicActivity = false;
+	for(unsigned i=0; i<NUM_CHANNELS; i++)
+	{
+		logicActivity |= channels[i]->logicLayer->activeContextCycles>0;
+	}
+	if(logicActivity)
+	{
+		PRINT(" == Logic Layer ("<<LOGIC_OPERATION_CONTEXTS<<" contexts per channel)");
+		PRINT("    started  completed   occupancy   avg latency(ns)   ops/us");
+		for(unsigned i=0; i<NUM_CHANNELS; i++)
+		{
+			LogicLayerInterface *logic = channels[i]->logicLayer;
+			float occupancy = logic->statCycles==0 ? 0 : (float)logic->activeContextCycles/(logic->statCycles*LOGIC_OPERATION_CONTEXTS)*100.0;
+			float latency = logic->opsCompleted==0 ? 0 : (float)logic->opLatencyTotal/logic->opsCompleted*tCK;
+			PRINT("  "<<i<<"] "<<setw(7)<<logic->opsStarted<<"  "<<setw(9)<<logic->opsCompleted<<"  "<<setw(9)<<occupancy<<"%   "<<
+			      setw(15)<<latency<<"   "<<setw(6)<<(float)logic->opsCompleted/(elapsedCycles*CPU_CLK_PERIOD/1000.0));
+			logic->opsStarted = 0;
+			logic->opsCompleted = 0;
+			logic->opLatencyTotal = 0;
+			logic->activeContextCycles = 0;
+		}
+
+		PRINT("    -- Queues      ops (max "<<LOGIC_OP_QUEUE_DEPTH<<")   outgoing (max "<<LOGIC_OUTGOING_QUEUE_DEPTH<<
+		      ")   reads out (max "<<LOGIC_RETURN_QUEUE_DEPTH<<")   ops held back");
+		PRINT("               avg / max        avg / max        avg / max");
+		for(unsigned i=0; i<NUM_CHANNELS; i++)
+		{
+			LogicLayerInterface *logic = channels[i]->logicLayer;
+			float cycles = logic->statCycles==0 ? 1 : logic->statCycles;
+			PRINT("  "<<i<<"]      "<<setw(8)<<logic->pendingOpsOccupancy/cycles<<" / "<<setw(3)<<logic->pendingOpsMax<<
+			      "   "<<setw(8)<<logic->outgoingOccupancy/cycles<<" / "<<setw(3)<<logic->outgoingMax<<
+			      "   "<<setw(8)<<logic->readsOutOccupancy/cycles<<" / "<<setw(3)<<logic->readsOutMax<<
+			      "   "<<setw(13)<<logicOpsHeld[i]);
+			logic->ResetQueueStats();
+			logicOpsHeld[i] = 0;
+		}
+
+		bool atomics = false;
+		for(unsigned i=0; i<NUM_CHANNELS; i++)
+		{
+			atomics |= channels[i]->logicLayer->atomicsCompleted>0 || channels[i]->logicLayer->lockWaitCycles>0;
+		}
+		if(atomics)
+		{
+			PRINT("    -- Atomics    completed   ops/us   avg latency(ns)   lock wait(ns)");
+			for(unsigned i=0; i<NUM_CHANNELS; i++)
+			{
+				LogicLayerInterface *logic = channels[i]->logicLayer;
+				PRINT("  "<<i<<"]          "<<setw(9)<<logic->atomicsCompleted<<"   "<<setw(6)<<(float)logic->atomicsCompleted/(elapsedCycles*CPU_CLK_PERIOD/1000.0)<<
+				      "   "<<setw(15)<<(logic->atomicsCompleted==0 ? 0 : (float)logic->atomicLatencyTotal/logic->atomicsCompleted*tCK)<<
+				      "   "<<setw(13)<<(logic->atomicsCompleted==0 ? 0 : (float)logic->lockWaitCycles/logic->atomicsCompleted*tCK));
+				logic->atomicsCompleted = 0;
+				logic->atomicLatencyTotal = 0;
+				logic->lockWaitCycles = 0;
+			}
+		}
+
+		unsigned chases = 0;
+		uint64_t chaseHops = 0;
+		uint64_t hopLatency = 0;
+		for(unsigned i=0; i<NUM_CHANNELS; i++)
+		{
+			chases += channels[i]->logicLayer->chasesCompleted;
+			chaseHops += channels[i]->logicLayer->chaseHops;
+			hopLatency += channels[i]->logicLayer->hopLatencyTotal;
+			channels[i]->logicLayer->chasesCompleted = 0;
+			channels[i]->logicLayer->chaseHops = 0;
+			channels[i]->logicLayer->hopLatencyTotal = 0;
+		}
+		if(chaseHops>0)
+		{
+			//each hop would otherwise be a full read round trip from the CPU
+			PRINT("    -- Pointer chases : "<<chases<<"   Hops : "<<chaseHops<<" ("<<(chases==0 ? 0 : (float)chaseHops/chases)<<" per chase)"<<
+			      "   Avg hop latency : "<<(float)hopLatency/chaseHops*tCK<<" ns");
+		}
+
+		unsigned fillLines = 0;
+		unsigned fillActivates = 0;
+		for(unsigned i=0; i<NUM_CHANNELS; i++)
+		{
+			fillLines += channels[i]->simpleController.fillLines;
+			fillActivates += channels[i]->simpleController.fillActivates;
+			channels[i]->simpleController.fillLines = 0;
+			channels[i]->simpleController.fillActivates = 0;
+		}
+		if(fillLines>0)
+		{
+			PRINT("    -- Row burst fills : "<<fillLines<<" lines with "<<fillActivates<<" ACTIVATEs ("<<(float)fillLines/fillActivates<<" lines per row)");
+		}
+
+		unsigned reduces = 0;
+		uint64_t linesReduced = 0;
+		for(unsigned i=0; i<NUM_CHANNELS; i++)
+		{
+			reduces += channels[i]->logicLayer->reducesCompleted;
+			linesReduced += channels[i]->logicLayer->linesReduced;
+			channels[i]->logicLayer->reducesCompleted = 0;
+			channels[i]->logicLayer->linesReduced = 0;
+		}
+		if(reduces>0)
+		{
+			PRINT("    -- Reductions : "<<reduces<<"   Lines reduced : "<<linesReduced);
+		}
+	}
+	else
+	{
+		for(unsigned i=0; i<NUM_CHANNELS; i++)
+		{
+			channels[i]->logicLayer->ResetQueueStats();
+			logicOpsHeld[i] = 0;
+		}
+	}
 	readCounter = 0;
 	writeCounter = 0;
 	totalRequestsAtChannels = 0;
@@ -1035,17 +2373,58 @@ void BOB::PrintStats(ofstream &statsOut, ofstream &powerOut, bool finalPrint, un
 		PRINT(" -- DRAM Power : "<<totalChannelPower<<" w");
 	}
 
+	if(ENABLE_LANE_REBALANCING)
+	{
+		PRINT(" == Lane Rebalancing ("<<REQUEST_LINK_BUS_WIDTH+RESPONSE_LINK_BUS_WIDTH<<" lanes per link bus)");
+		for(unsigned l=0; l<NUM_LINK_BUSES; l++)
+		{
+			PRINT("    -- Link Bus "<<l<<" - lanes now (req/rsp) : "<<requestLinkLanes[l]<<"/"<<responseLinkLanes[l]<<
+			      "   avg : "<<(float)requestLanesOnAvg[l]/elapsedCycles<<"/"<<(float)responseLanesOnAvg[l]/elapsedCycles<<
+			      "   BW(req/rsp) : "<<requestLinkBytes[l]/(elapsedCycles*CPU_CLK_PERIOD)<<"/"<<responseLinkBytes[l]/(elapsedCycles*CPU_CLK_PERIOD)<<" GB/s"<<
+			      "   switches : "<<laneSwitches[l]);
+			laneSwitches[l]=0;
+		}
+	}
+
+	PRINT(" == Link Power");
+	float allLinkPower = 0;
+	for(unsigned l=0; l<NUM_LINK_BUSES; l++)
+	{
+		float linkPower = linkEnergy[l] / elapsedCycles;
+		allLinkPower += linkPower;
+		PRINTN("    -- Link Bus "<<l<<" : "<<linkPower<<" w");
+		if(ENABLE_LINK_DVFS)
+		{
+			PRINTN("   lanes(req/rsp) : "<<(float)requestLanesOnAvg[l]/elapsedCycles<<"/"<<(float)responseLanesOnAvg[l]/elapsedCycles<<
+			       "   clkDiv : "<<(float)linkClockDividerAvg[l]/elapsedCycles<<
+			       "   BW(req/rsp) : "<<requestLinkBytes[l]/(elapsedCycles*CPU_CLK_PERIOD)<<"/"<<responseLinkBytes[l]/(elapsedCycles*CPU_CLK_PERIOD)<<" GB/s"<<
+			       "   reconfigs : "<<linkReconfigs[l]<<" ("<<linkReconfigCycles[l]*CPU_CLK_PERIOD<<" ns)");
+		}
+		PRINT("");
+		powerOut<<linkPower<<",";
+
+		linkEnergy[l]=0;
+		requestLinkBytes[l]=0;
+		responseLinkBytes[l]=0;
+		requestLanesOnAvg[l]=0;
+		responseLanesOnAvg[l]=0;
+		linkClockDividerAvg[l]=0;
+		linkReconfigs[l]=0;
+		linkReconfigCycles[l]=0;
+	}
+
 	PRINT("   Average Power  : "<<allChanAveragePower/NUM_CHANNELS<<" w");
 	PRINT("   Total Power    : "<<allChanAveragePower<<" w");
-	PRINT("   SimpCont BG Power : "<<NUM_LINK_BUSES * SIMP_CONT_BACKGROUND_POWER<<" w");
+	PRINT("   SimpCont BG Power : "<<numBuffers * SIMP_CONT_BACKGROUND_POWER<<" w");
 	PRINT("   SimpCont Core Power : "<<NUM_CHANNELS * SIMP_CONT_CORE_POWER<<" w");
-	PRINT("   System Power   : "<<allChanAveragePower + NUM_LINK_BUSES * SIMP_CONT_BACKGROUND_POWER + NUM_CHANNELS * SIMP_CONT_CORE_POWER<<" w");
+	PRINT("   Link Power     : "<<allLinkPower<<" w");
+	PRINT("   System Power   : "<<allChanAveragePower + numBuffers * SIMP_CONT_BACKGROUND_POWER + NUM_CHANNELS * SIMP_CONT_CORE_POWER + allLinkPower<<" w");
 
 	statsOut << ";" << allChanAveragePower/NUM_CHANNELS << endl;
 
 	//compute static power from controllers
-	powerOut<<SIMP_CONT_BACKGROUND_POWER * NUM_LINK_BUSES + NUM_CHANNELS * SIMP_CONT_CORE_POWER <<",";
-	powerOut<<(SIMP_CONT_BACKGROUND_POWER * NUM_LINK_BUSES + NUM_CHANNELS * SIMP_CONT_CORE_POWER) + allChanAveragePower<<endl;
+	powerOut<<SIMP_CONT_BACKGROUND_POWER * numBuffers + NUM_CHANNELS * SIMP_CONT_CORE_POWER <<",";
+	powerOut<<(SIMP_CONT_BACKGROUND_POWER * numBuffers + NUM_CHANNELS * SIMP_CONT_CORE_POWER) + allChanAveragePower + allLinkPower<<endl;
 
 	PRINT(" == Time Check");
 	PRINT("    CPU Time : "<<currentClockCycle * CPU_CLK_PERIOD<<"ns");
@@ -38,17 +38,56 @@
 #include "DRAMChannel.h"
 #include "SimpleController.h"
 #include "Port.h"
+#include "Bitmap.h"
+#include "ReadBuffer.h"
+#include <deque>
+#include <map>
 
 using namespace std;
 
 namespace BOBSim
 {
+//Data moving between logic layers on the side-band path
+struct LogicTransfer
+{
+	Transaction *data; //write headed for the destination channel
+	unsigned sourceChannel;
+	uint64_t sendCycle; //cycle it was taken from the source logic layer
+	uint64_t arrivalCycle;
+};
+
 class BOB : public SimulatorObject
 {
 public:
 	//Functions
 	BOB();
 	unsigned FindChannelID(Transaction* trans);
+	unsigned FindChannelID(uint64_t address);
+	void UpdatePortLoad(unsigned port);
+	void UpdatePortOccupancy(unsigned port);
+	void AddToInputBuffer(Transaction *trans, unsigned port);
+	void AddToOutputBuffer(Transaction *trans);
+	void ReleaseReadWaiters(Transaction *trans);
+	bool MovePortToSerDes(unsigned p, unsigned linkBusID);
+	unsigned LinkBusCycles(unsigned packetBytes, unsigned linkBusWidth, unsigned clockDivider);
+	unsigned RequestLinkWidth(unsigned link);
+	unsigned ResponseLinkWidth(unsigned link);
+	bool LinkAvailable(unsigned link);
+	void UpdateLinkConfiguration();
+	unsigned LinkPayloadSize(Transaction *trans);
+	unsigned LogicResponseSize(Transaction *trans);
+	unsigned LogicResponsePortCycles(Transaction *trans);
+	void BuildTopology();
+	uint64_t ForwardThroughHops(unsigned chan, unsigned packetBytes, bool request);
+	void UpdateDaisyChains();
+	unsigned LogicChannelOf(uint64_t address, unsigned notused);
+	void LogicWrite(uint64_t address, unsigned notused);
+	LogicLayerInterface *LogicLayerOf(uint64_t address, unsigned notused);
+	void UpdateLogicTransfers();
+	void DeliverToChannel(Transaction *trans, unsigned link);
+	void AddToChannel(Transaction *trans, unsigned link);
+	Transaction *ResponseCandidate(unsigned chan);
+	bool SelectResponseChannel(unsigned link, unsigned &chosenChannel);
 	void Update();
 	void PrintStats(ofstream &statsOut, ofstream &powerOut, bool finalPrint, unsigned elapsedCycles);
 	void ReportCallback(BusPacket *bp, unsigned i);
@@ -63,44 +102,187 @@ public:
 	//Bookkeeping for the number of requests to each channel
 	vector<unsigned> channelCounters;
 	vector<uint64_t> channelCountersLifetime;
+	//Requests sitting in a SerDes buffer or on a link bus headed to each channel
+	vector<unsigned> requestsInTransit;
+	//Logic ops headed to each channel's logic layer and how often one was held back because
+	//  the logic layer's queue had no room for it
+	vector<unsigned> logicOpsInTransit;
+	vector<unsigned> logicOpsHeld;
+
+	//
+	//Topology - routing tables built from LINK_TOPOLOGY at startup
+	//
+	//Link bus, buffer along that link bus (0 is the one the link bus connects to) and
+	//  position among the link bus' channels for each channel
+	vector<unsigned> channelLink;
+	vector<unsigned> channelHop;
+	vector<unsigned> channelSlot;
+	//Channels on each link bus, in round-robin order
+	vector< vector<unsigned> > linkChannels;
+	//Channels which sit behind at least one forwarding hop
+	vector<unsigned> forwardedChannels;
+	//Total number of buffer chips (simple controllers) across all link buses
+	unsigned numBuffers;
+	//Per link bus, per hop (indexed by the buffer the hop leads to - entry 0 is unused)
+	vector< vector<unsigned> > hopLatency;
+	vector< vector<unsigned> > hopRequestLanes;
+	vector< vector<unsigned> > hopResponseLanes;
+	//Cycle each direction of a hop is free to start another packet
+	vector< vector<uint64_t> > hopRequestFree;
+	vector< vector<uint64_t> > hopResponseFree;
+	//Requests being forwarded to a channel (arrival cycle, packet)
+	vector< deque< pair<uint64_t, Transaction *> > > forwardedRequests;
+	//Cycles that responses forwarded from a channel reach the first buffer
+	vector< deque<uint64_t> > forwardedResponses;
+	//Bookkeeping for hop utilization
+	vector< vector<uint64_t> > hopRequestBusy;
+	vector< vector<uint64_t> > hopResponseBusy;
+
+	//Side-band path between logic layers - data on its way, oldest first
+	deque<LogicTransfer> logicTransfers;
+	//Cycles until the path can take the next piece of data
+	unsigned logicTransferCountdown;
+	//Logic layer the path looks at first
+	unsigned logicTransferRoundRobin;
+	//Bookkeeping for the side-band path
+	unsigned logicTransfersDone;
+	uint64_t logicTransferLatency;
+	uint64_t logicTransferBytes;
+	uint64_t logicTransferBusy;
+
+	//Recently read lines kept on the main BOB controller
+	ReadBuffer readBuffer;
+	//Reads answered by the read buffer (cycle the data is ready, packet)
+	deque< pair<uint64_t, Transaction *> > readBufferReturns;
+	//Bookkeeping for the read buffer - latencies are from the start of the request on the port
+	uint64_t readBufferHitLatency;
+	uint64_t readBufferMissLatency;
+	unsigned readBufferMisses;
+
+	//Cache lines with a read outstanding (line, transaction ID of that read) - writes take
+	//  the line out so later reads don't get data from before the write
+	map<uint64_t, unsigned> outstandingReadLines;
+	//Reads waiting on the data of another read to the same line, by that read's transaction ID
+	map<unsigned, vector<Transaction *> > readWaiters;
+	//Waiting reads whose data has come back, on their way to their ports
+	vector<Transaction *> coalescedReturns;
+	//Bookkeeping for read coalescing
+	unsigned readsCoalesced;
+	unsigned readWaitersFull;
 
 	//Storage for pending read request information
 	vector<Transaction *> pendingReads;
 
 	//Bookkeeping for port statistics
-	vector<uint> portInputBufferAvg;
-	vector<uint> portOutputBufferAvg;
+	vector<uint64_t> portInputBufferAvg;
+	vector<uint64_t> portOutputBufferAvg;
+	//Cycle each port's buffer averages were last brought up to date
+	vector<uint64_t> portOccupancyUpdated;
 
 	//
 	//Request Link Bus
 	//
-	//SerDes buffer for holding outgoing request packet
-	vector<Transaction *> serDesBufferRequest;
+	//SerDes buffers for holding outgoing request packets
+	vector< deque<Transaction *> > serDesBufferRequest;
 	//The packet which is currently being sent
 	vector<Transaction *> inFlightRequestLink;
+	//Additional reads packed into the packet which is currently being sent
+	vector< vector<Transaction *> > coalescedRequests;
+	//Compressed packets waiting out the compressor/decompressor latency (ready cycle, packet)
+	vector< deque< pair<uint64_t, Transaction *> > > requestLinkDecompress;
 	//Counter to determine how long packet is to be sent
 	vector<unsigned> inFlightRequestLinkCountdowns;
 	//Counts cycles that request link bus is idle
 	vector<unsigned> requestLinkIdle;
+	//Bookkeeping for request coalescing
+	vector<unsigned> requestLinkReadPackets;
+	vector<unsigned> requestLinkReads;
+	vector<uint64_t> requestLinkBytes;
+	vector<uint64_t> requestLinkEquivalentBytes;
 
 	//
 	//Response Link Bus
 	//
-	//SerDes buffer for holding incoming request packet
-	vector<Transaction *> serDesBufferResponse;
+	//SerDes buffers for holding incoming response packets
+	vector< deque<Transaction *> > serDesBufferResponse;
 	//The packet which is currently being sent
 	vector<Transaction *> inFlightResponseLink;
 	//Coutner to determine how long packet is to be sent
 	vector<unsigned> inFlightResponseLinkCountdowns;
 	//Counts cycles that response link bus is idle
 	vector<unsigned> responseLinkIdle;
+	//Compressed packets waiting out the compressor/decompressor latency (ready cycle, packet)
+	vector< deque< pair<uint64_t, Transaction *> > > responseLinkDecompress;
+
+	//Bookkeeping for link compression
+	unsigned compressionSeed;
+	vector<uint64_t> requestPayloadBytes;
+	vector<uint64_t> requestCompressedBytes;
+	vector<uint64_t> responsePayloadBytes;
+	vector<uint64_t> responseCompressedBytes;
+	vector<unsigned> compressedPackets;
 
 	//Round-robin counter
 	vector<unsigned> responseLinkRoundRobin;
+	//Bytes sent on response link bus
+	vector<uint64_t> responseLinkBytes;
+
+	//
+	//Link bus power state
+	//
+	//Lanes given to each direction of a link bus
+	vector<unsigned> requestLinkLanes;
+	vector<unsigned> responseLinkLanes;
+	//Lanes that are on are the configured lanes shifted right by this much
+	vector<unsigned> linkLaneShift;
+	//Link clock runs at the full link clock divided by this
+	vector<unsigned> linkClockDivider;
+	//Settings the governor wants - applied once the link is empty
+	vector<unsigned> targetLaneShift;
+	vector<unsigned> targetClockDivider;
+	vector<unsigned> targetRequestLanes;
+	//Counts down while lanes retrain
+	vector<unsigned> linkReconfigCountdown;
+	//Cycles with something sent or waiting to be sent since the governor last ran
+	vector<unsigned> requestLinkBusyInterval;
+	vector<unsigned> responseLinkBusyInterval;
+
+	//Bookkeeping for link power
+	vector<double> linkEnergy; //watt-cycles
+	vector<uint64_t> requestLanesOnAvg;
+	vector<uint64_t> responseLanesOnAvg;
+	vector<uint64_t> linkClockDividerAvg;
+	vector<unsigned> linkReconfigs;
+	vector<unsigned> linkReconfigCycles;
+	vector<unsigned> laneSwitches;
+
+	//Per-channel histogram of cycles read data waited in the return queue for the response link
+	vector< vector<uint64_t> > responseWaitHistogram;
+	vector<unsigned> responseWaitMax;
+
+	//Bookkeeping for SerDes buffer occupancy
+	vector<uint64_t> serDesRequestOccupancy;
+	vector<uint64_t> serDesResponseOccupancy;
+	vector<unsigned> serDesRequestMax;
+	vector<unsigned> serDesResponseMax;
 
 	//Used for round-robin 
-	unsigned priorityPort;
-	vector<unsigned> priorityLinkBus;
+	unsigned priorityRequestLink;
+	vector<unsigned> linkPriorityPort;
+	//For each link bus, the ports which have requests headed to it
+	vector<Bitmap> portsWithRequests;
+	//Ports grouped by how many requests are in their input buffers, and by that plus
+	//  the responses they are waiting on (capped at PORT_LOAD_LEVELS-1)
+	vector<Bitmap> portsAtInputLevel;
+	vector<Bitmap> portsAtLoadLevel;
+	vector<unsigned> portInputLevel;
+	vector<unsigned> portLoadLevel;
+	unsigned priorityResponseLink;
+	//Ports whose input or output is busy moving a packet
+	Bitmap portsInputBusy;
+	Bitmap portsOutputBusy;
+	//Ports with responses in their output buffers
+	Bitmap portsWithOutput;
 
 	//Bookkeeping 
 	vector<uint> cmdQFull;
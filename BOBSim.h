@@ -33,6 +33,7 @@
 #define BOBSIM_H
 
 #include "Callback.h"
+#include "LogicOperationHandler.h"
 #include <vector>
 
 namespace BOBSim
@@ -50,6 +51,33 @@ public:
 };
 BOBWrapper *getMemorySystemInstance(uint64_t qemu_mem_size);
 void *getPageWalkLogicOp(uint64_t baseAddr, std::vector<uint64_t> *args);
+//Reduces numLines of the channel's lines starting at the address the op is sent to (one column
+//  apart, the same lines a PAGE_FILL of that size writes) - reduceFunction is 0:sum, 1:min, 2:max, 3:count of nonzero words
+void *getReduceLogicOp(uint64_t numLines, unsigned reduceFunction);
+//Reads (or writes) the elementSize-byte elements at the given indices from the address the op is
+//  sent to - gathered elements come back packed in the response
+void *getGatherLogicOp(unsigned elementSize, std::vector<uint64_t> *indices);
+void *getScatterLogicOp(unsigned elementSize, std::vector<uint64_t> *indices);
+//Atomics on the 8-byte word at the address the op is sent to - the result is the old value
+void *getAtomicAddLogicOp(uint64_t value);
+void *getAtomicCASLogicOp(uint64_t expected, uint64_t desired);
+void *getAtomicSwapLogicOp(uint64_t value);
+//Follows a linked structure from the address the op is sent to, one dependent read per node - the next
+//  pointer is the word at nextOffset in each node, or the next entry of nodes if it isn't NULL. The
+//  result is the last node reached
+void *getChaseLogicOp(uint64_t maxHops, unsigned nextOffset, std::vector<uint64_t> *nodes);
+//Any logic op - for types from LogicOperation::FIRST_USER_LOGIC_TYPE up, requestPayload is the bytes
+//  the op carries to memory besides its header and resultSize the bytes its response carries back
+//  (built-in types size themselves)
+void *getLogicOp(unsigned logicType, std::vector<uint64_t> *args, unsigned requestPayload, unsigned resultSize);
+//Has handler carry out every logic op of a user-defined type, in every logic layer
+void registerLogicOpHandler(unsigned logicType, LogicOperationHandler *handler);
+//Result of a logic op once its response has come back
+uint64_t getLogicOpResult(void *logicOp);
+//What a handler uses to work on its op - the arguments can also hold the op's own state
+unsigned getLogicOpType(void *logicOp);
+std::vector<uint64_t> &getLogicOpArguments(void *logicOp);
+void setLogicOpResult(void *logicOp, uint64_t result);
 }
 
 
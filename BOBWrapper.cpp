@@ -30,6 +30,9 @@
 
 #include "BOBWrapper.h"
 #include "LogicOperation.h"
+#include "LogicLayerInterface.h"
+#include <algorithm>
+#include <sstream>
 
 using namespace std;
 
@@ -37,6 +40,8 @@ namespace BOBSim
 {
 
 uint64_t QEMU_MEMORY_SIZE;
+PortHeuristicScheme portHeuristic = FIRST_AVAILABLE;
+std::string LINK_TOPOLOGY;
 
 BOBWrapper::BOBWrapper(uint64_t qemu_mem_size) :
 	readDoneCallback(NULL),
@@ -100,12 +105,15 @@ BOBWrapper::BOBWrapper(uint64_t qemu_mem_size) :
 	inFlightResponseHeaderCounter = vector<unsigned>(NUM_PORTS,0);
 
 	//For statistics & bookkeeping
-	requestPortEmptyCount = vector<unsigned>(NUM_PORTS,0);
-	responsePortEmptyCount = vector<unsigned>(NUM_PORTS,0);
+	requestPortBusyCount = vector<unsigned>(NUM_PORTS,0);
+	responsePortBusyCount = vector<unsigned>(NUM_PORTS,0);
 	requestCounterPerPort = vector<unsigned>(NUM_PORTS,0);
 	readsPerPort = vector<unsigned>(NUM_PORTS,0);
 	writesPerPort = vector<unsigned>(NUM_PORTS,0);
 	returnsPerPort = vector<unsigned>(NUM_PORTS,0);
+	latencyPerPort = vector<uint64_t>(NUM_PORTS,0);
+	portsReceiving = Bitmap(NUM_PORTS);
+	portsSending = Bitmap(NUM_PORTS);
 	perChanFullLatencies = vector< vector<unsigned> >(NUM_CHANNELS, vector<unsigned>());
 	perChanReqPort = vector< vector<unsigned> >(NUM_CHANNELS, vector<unsigned>());
 	perChanRspPort = vector< vector<unsigned> >(NUM_CHANNELS, vector<unsigned>());
@@ -202,19 +210,183 @@ void *getPageWalkLogicOp(uint64_t baseAddr, vector<uint64_t> *args)
 	LogicOperation *lo = new LogicOperation(LogicOperation::PAGE_TABLE_WALK, *args);
 	return (void*)(lo);
 }
+void *getReduceLogicOp(uint64_t numLines, unsigned reduceFunction)
+{
+	if (reduceFunction > LogicOperation::REDUCE_COUNT)
+	{
+		ERROR(" == Got a reduce logic op with an unknown function : "<<reduceFunction);
+		exit(0);
+	}
+
+	vector<uint64_t> args;
+	args.push_back(numLines);
+	args.push_back(reduceFunction);
+	LogicOperation *lo = new LogicOperation(LogicOperation::REDUCE, args);
+	return (void*)(lo);
+}
+void *getGatherLogicOp(unsigned elementSize, vector<uint64_t> *indices)
+{
+	if (!indices)
+	{
+		ERROR(" == Got a gather logic op without an index vector");
+		exit(0);
+	}
+
+	vector<uint64_t> args;
+	args.push_back(elementSize);
+	args.insert(args.end(), indices->begin(), indices->end());
+	LogicOperation *lo = new LogicOperation(LogicOperation::GATHER, args);
+	return (void*)(lo);
+}
+void *getScatterLogicOp(unsigned elementSize, vector<uint64_t> *indices)
+{
+	if (!indices)
+	{
+		ERROR(" == Got a scatter logic op without an index vector");
+		exit(0);
+	}
 
-inline bool BOBWrapper::isPortAvailable(unsigned port)
+	vector<uint64_t> args;
+	args.push_back(elementSize);
+	args.insert(args.end(), indices->begin(), indices->end());
+	LogicOperation *lo = new LogicOperation(LogicOperation::SCATTER, args);
+	return (void*)(lo);
+}
+void *getAtomicAddLogicOp(uint64_t value)
+{
+	vector<uint64_t> args;
+	args.push_back(value);
+	LogicOperation *lo = new LogicOperation(LogicOperation::ATOMIC_ADD, args);
+	return (void*)(lo);
+}
+void *getAtomicCASLogicOp(uint64_t expected, uint64_t desired)
+{
+	vector<uint64_t> args;
+	args.push_back(expected);
+	args.push_back(desired);
+	LogicOperation *lo = new LogicOperation(LogicOperation::ATOMIC_CAS, args);
+	return (void*)(lo);
+}
+void *getAtomicSwapLogicOp(uint64_t value)
+{
+	vector<uint64_t> args;
+	args.push_back(value);
+	LogicOperation *lo = new LogicOperation(LogicOperation::ATOMIC_SWAP, args);
+	return (void*)(lo);
+}
+void *getChaseLogicOp(uint64_t maxHops, unsigned nextOffset, vector<uint64_t> *nodes)
+{
+	vector<uint64_t> args;
+	args.push_back(maxHops);
+	args.push_back(nextOffset);
+	if (nodes)
+	{
+		args.insert(args.end(), nodes->begin(), nodes->end());
+	}
+	LogicOperation *lo = new LogicOperation(LogicOperation::CHASE, args);
+	return (void*)(lo);
+}
+void *getLogicOp(unsigned logicType, vector<uint64_t> *args, unsigned requestPayload, unsigned resultSize)
+{
+	if (!args)
+	{
+		ERROR(" == Got a logic op without an arguments vector");
+		exit(0);
+	}
+	if (logicType > LogicOperation::CHASE && logicType < LogicOperation::FIRST_USER_LOGIC_TYPE)
+	{
+		ERROR(" == Got an unknown logic op type "<<logicType<<" (user-defined types start at "<<LogicOperation::FIRST_USER_LOGIC_TYPE<<")");
+		exit(0);
+	}
+
+	LogicOperation *lo = new LogicOperation(logicType, *args);
+	if (logicType >= LogicOperation::FIRST_USER_LOGIC_TYPE)
+	{
+		lo->requestPayload = requestPayload;
+		lo->resultSize = resultSize;
+	}
+	return (void*)(lo);
+}
+void registerLogicOpHandler(unsigned logicType, LogicOperationHandler *handler)
+{
+	LogicLayerInterface::RegisterHandler(logicType, handler);
+}
+uint64_t getLogicOpResult(void *logicOp)
+{
+	return ((LogicOperation *)logicOp)->result;
+}
+unsigned getLogicOpType(void *logicOp)
+{
+	return ((LogicOperation *)logicOp)->logicType;
+}
+vector<uint64_t> &getLogicOpArguments(void *logicOp)
+{
+	return ((LogicOperation *)logicOp)->arguments;
+}
+void setLogicOpResult(void *logicOp, uint64_t result)
+{
+	((LogicOperation *)logicOp)->result = result;
+}
+
+bool BOBWrapper::isPortAvailable(unsigned port)
 {
 	return inFlightRequestCounter[port] == 0 &&
-	       bob->ports[port].inputBuffer.size()<PORT_QUEUE_DEPTH;
+	       bob->ports[port].inputBufferCount<PORT_QUEUE_DEPTH;
 }
 
 
+//Returns the available port among numPorts ports from firstPort in the lowest group, starting
+//  from the round-robin index within a group, or -1 if every one of them is busy or full
+int BOBWrapper::LeastLoadedPort(vector<Bitmap> &portsAtLevel, unsigned firstPort, unsigned numPorts)
+{
+	Bitmap &fullPorts = bob->portsAtInputLevel[PORT_QUEUE_DEPTH];
+	int endPort = firstPort + numPorts;
+	unsigned start = portRoundRobin>=firstPort && (int)portRoundRobin<endPort ? portRoundRobin : firstPort;
+	for(unsigned level=0; level<portsAtLevel.size(); level++)
+	{
+		int port = portsAtLevel[level].FindNextSet(start, portsReceiving, fullPorts);
+		if(port==-1 || port>=endPort)
+		{
+			port = portsAtLevel[level].FindNextSet(firstPort, portsReceiving, fullPorts);
+		}
+		if(port!=-1 && port<endPort)
+		{
+			portRoundRobin = (port+1)%NUM_PORTS;
+			return port;
+		}
+	}
+	return -1;
+}
+
 //Uses the port heuristic to determine which port should be used to receive a request
-inline int BOBWrapper::FindOpenPort(uint coreID)
+int BOBWrapper::FindOpenPort(uint coreID, uint64_t addr)
 {
 	switch(portHeuristic)
 	{
+	case LEAST_OCCUPIED:
+		return LeastLoadedPort(bob->portsAtInputLevel, 0, NUM_PORTS);
+	case JOIN_SHORTEST_QUEUE:
+		return LeastLoadedPort(bob->portsAtLoadLevel, 0, NUM_PORTS);
+	case ADDRESS_HASHED:
+	{
+		//requests to the same channel share a port - if there are more ports than
+		//  channels, each core gets its own set
+		unsigned setStart = 0;
+		unsigned setSize = NUM_PORTS;
+		if(NUM_PORTS > NUM_CHANNELS)
+		{
+			setStart = NUM_CHANNELS * (coreID % (NUM_PORTS / NUM_CHANNELS));
+			setSize = NUM_CHANNELS;
+		}
+		unsigned port = (setStart + bob->FindChannelID(addr)) % NUM_PORTS;
+		if(isPortAvailable(port))
+		{
+			return port;
+		}
+
+		//the hashed port is busy - fall back to the least occupied port in the core's set
+		return LeastLoadedPort(bob->portsAtInputLevel, setStart, setSize);
+	}
 	case FIRST_AVAILABLE:
 		for (unsigned i=0; i<NUM_PORTS; i++)
 		{
@@ -231,6 +403,7 @@ inline int BOBWrapper::FindOpenPort(uint coreID)
 		}
 		break;
 	case ROUND_ROBIN:
+	{
 		int startIndex = portRoundRobin;
 		do
 		{
@@ -248,6 +421,7 @@ inline int BOBWrapper::FindOpenPort(uint coreID)
 		while(startIndex!=portRoundRobin);
 
 		break;
+	}
 	};
 	return -1;
 }
@@ -263,7 +437,7 @@ bool BOBWrapper::AddTransaction(uint64_t addr, bool isWrite, int coreID, void *l
 	TransactionType type = isLogicOp ? LOGIC_OPERATION : (isWrite ? DATA_WRITE : DATA_READ) ;
 	Transaction *trans;
 
-	if ((openPort = FindOpenPort(coreID)) > -1)
+	if ((openPort = FindOpenPort(coreID, addr)) > -1)
 	{
 		trans = new Transaction(type, TRANSACTION_SIZE, addr);
 		trans->portID = openPort;
@@ -271,6 +445,14 @@ bool BOBWrapper::AddTransaction(uint64_t addr, bool isWrite, int coreID, void *l
 		if (isLogicOp)
 		{
 			trans->logicOpContents = logicOperation;
+
+			//ops carrying more than fits in a regular request (e.g., index lists) get a bigger packet
+			unsigned payload = ((LogicOperation *)logicOperation)->requestPayload;
+			if(payload>0)
+			{
+				unsigned packetBytes = WR_REQUEST_PACKET_OVERHEAD + payload;
+				trans->transactionSize = max(TRANSACTION_SIZE, (packetBytes / PORT_WIDTH + !!(packetBytes % PORT_WIDTH)) * PORT_WIDTH);
+			}
 		}
 		if(currentClockCycle<5000)
 		{
@@ -301,7 +483,7 @@ void BOBWrapper::RegisterCallbacks(TransactionCompleteCB *_readDone, Transaction
 bool BOBWrapper::AddTransaction(Transaction* trans, unsigned port)
 {
 	if(inFlightRequestCounter[port]==0 &&
-	        bob->ports[port].inputBuffer.size()<PORT_QUEUE_DEPTH)
+	        bob->ports[port].inputBufferCount<PORT_QUEUE_DEPTH)
 	{
 		trans->fullStartTime = currentClockCycle;
 		requestCounterPerPort[port]++;
@@ -311,29 +493,35 @@ bool BOBWrapper::AddTransaction(Transaction* trans, unsigned port)
 		inFlightRequest[port]->cyclesReqPort = currentClockCycle;
 
 		inFlightRequestHeaderCounter[port] = 1;
+		portsReceiving.Set(port);
 
 		switch(trans->transactionType)
 		{
 		case DATA_READ:
 			readsPerPort[port]++;
 			inFlightRequestCounter[port] = 1;
+			bob->ports[port].responsesPending++;
 			break;
 		case DATA_WRITE:
 			issuedWrites++;
 			writesPerPort[port]++;
-			inFlightRequestCounter[port] = TRANSACTION_SIZE / PORT_WIDTH;
+			inFlightRequestCounter[port] = trans->transactionSize / PORT_WIDTH + !!(trans->transactionSize % PORT_WIDTH);
 			break;
 		case LOGIC_OPERATION:
 			issuedLogicOperations++;
-			inFlightRequestCounter[port] = TRANSACTION_SIZE / PORT_WIDTH;
+			//ops carrying an index list (or other payload) take longer to get across
+			inFlightRequestCounter[port] = trans->transactionSize / PORT_WIDTH + !!(trans->transactionSize % PORT_WIDTH);
+			bob->ports[port].responsesPending++;
 			break;
 		default:
 			ERROR(" = Error - wrong type");
 			ERROR(trans);
 			break;
 		}
+		requestPortBusyCount[port] += inFlightRequestCounter[port];
 
 		if(DEBUG_PORTS) DEBUG(" = Putting transaction on port "<<port<<" - "<<*inFlightRequest[port]<<" for "<<inFlightRequestCounter[port]<<" CPU cycles");
+		bob->UpdatePortLoad(port);
 
 		return true;
 	}
@@ -356,20 +544,9 @@ void BOBWrapper::Update()
 
 	bob->Update();
 
-	//BOOK-KEEPING
-	for(unsigned i=0; i<NUM_PORTS; i++)
+	//BOOK-KEEPING - only ports which are moving a packet have anything to do
+	for(int i=portsReceiving.FindNextSet(0); i!=-1; i=portsReceiving.FindNextSet(i+1))
 	{
-		//STATS
-		if(inFlightResponse[i]==NULL)
-		{
-			responsePortEmptyCount[i]++;
-		}
-
-		if(inFlightRequest[i]==NULL)
-		{
-			requestPortEmptyCount[i]++;
-		}
-
 		//
 		//Requests
 		//
@@ -382,7 +559,7 @@ void BOBWrapper::Update()
 				if(inFlightRequest[i]!=NULL)
 				{
 					if(DEBUG_PORTS)DEBUG("== Header done - Adding "<<*inFlightRequest[i]<<" to port "<<i);
-					bob->ports[i].inputBuffer.push_back(inFlightRequest[i]);
+					bob->AddToInputBuffer(inFlightRequest[i], i);
 				}
 				else
 				{
@@ -398,9 +575,12 @@ void BOBWrapper::Update()
 			if(inFlightRequestCounter[i]==0)
 			{
 				inFlightRequest[i]=NULL;
+				portsReceiving.Clear(i);
 			}
 		}
-
+	}
+	for(int i=portsSending.FindNextSet(0); i!=-1; i=portsSending.FindNextSet(i+1))
+	{
 		//
 		//Responses
 		//
@@ -425,6 +605,7 @@ void BOBWrapper::Update()
 					UpdateLatencyStats(inFlightResponse[i]);
 
 					returnsPerPort[i]++;
+					latencyPerPort[i]+=inFlightResponse[i]->fullTimeTotal;
 				}
 				else if(inFlightResponse[i]->transactionType==LOGIC_RESPONSE)
 				{
@@ -443,38 +624,45 @@ void BOBWrapper::Update()
 					exit(0);
 				}
 
+				bob->UpdatePortOccupancy(i);
 				bob->ports[i].outputBuffer.erase(bob->ports[i].outputBuffer.begin());
+				if(bob->ports[i].outputBuffer.empty())
+				{
+					bob->portsWithOutput.Clear(i);
+				}
+				bob->ports[i].responsesPending--;
+				bob->UpdatePortLoad(i);
 				delete inFlightResponse[i];
 				inFlightResponse[i]=NULL;
+				portsSending.Clear(i);
 			}
 		}
 	}
 
 	//NEW STUFF
-	for(unsigned i=0; i<NUM_PORTS; i++)
+	//look for new stuff to return from bob controller on ports which aren't already sending
+	for(int i=bob->portsWithOutput.FindNextSet(0, portsSending); i!=-1; i=bob->portsWithOutput.FindNextSet(i+1, portsSending))
 	{
-		//look for new stuff to return from bob controller
-		if(bob->ports[i].outputBuffer.size()>0 &&
-		        inFlightResponseCounter[i]==0)
-		{
-			inFlightResponse[i] = bob->ports[i].outputBuffer[0];
-			inFlightResponseHeaderCounter[i] = 1;
+		inFlightResponse[i] = bob->ports[i].outputBuffer[0];
+		inFlightResponseHeaderCounter[i] = 1;
 
-			if(inFlightResponse[i]->transactionType==RETURN_DATA)
-			{
-				inFlightResponseCounter[i] = TRANSACTION_SIZE / PORT_WIDTH;
-			}
-			else if(inFlightResponse[i]->transactionType==LOGIC_RESPONSE)
-			{
-				inFlightResponseCounter[i] = 1;
-			}
-			else
-			{
-				ERROR("== Error - wrong type of transaction out of");
-				ERROR("== "<<*inFlightResponse[i]);
-				exit(0);
-			}
+		if(inFlightResponse[i]->transactionType==RETURN_DATA)
+		{
+			inFlightResponseCounter[i] = TRANSACTION_SIZE / PORT_WIDTH;
+		}
+		else if(inFlightResponse[i]->transactionType==LOGIC_RESPONSE)
+		{
+			inFlightResponseCounter[i] = bob->LogicResponsePortCycles(inFlightResponse[i]);
+		}
+		else
+		{
+			ERROR("== Error - wrong type of transaction out of");
+			ERROR("== "<<*inFlightResponse[i]);
+			exit(0);
 		}
+
+		portsSending.Set(i);
+		responsePortBusyCount[i] += inFlightResponseCounter[i];
 	}
 
 	if(currentClockCycle%EPOCH_LENGTH==0 && currentClockCycle>0)
@@ -488,9 +676,10 @@ void BOBWrapper::UpdateLatencyStats(Transaction *returnedRead)
 {
 	if(returnedRead->transactionType==LOGIC_RESPONSE)
 	{
-		DEBUG("  == Got Logic Response : "<<*returnedRead);
-		DEBUG("  == Logic All Done!");
-		DEBUG("  == Took : "<<CPU_CLK_PERIOD*(currentClockCycle - returnedRead->fullStartTime)<<"ns");
+		returnedRead->fullTimeTotal = currentClockCycle - returnedRead->fullStartTime;
+		logicLatencies[((LogicOperation *)returnedRead->logicOpContents)->logicType].push_back(returnedRead->fullTimeTotal);
+
+		if(DEBUG_LOGIC) DEBUG("  == Got Logic Response : "<<*returnedRead<<" took "<<CPU_CLK_PERIOD*returnedRead->fullTimeTotal<<"ns");
 		return;
 	}
 	else if(returnedRead->transactionType==RETURN_DATA)
@@ -681,26 +870,34 @@ void BOBWrapper::PrintStats(bool finalPrint)
 		perChanRRQ[i].clear();
 	}
 
-	PRINT(" ---  Port stats (per epoch) : ");
+	const char *heuristicNames[] = {"first available", "round robin", "per core", "least occupied", "address hashed", "join shortest queue"};
+	PRINT(" ---  Port stats (per epoch, "<<heuristicNames[portHeuristic]<<" port heuristic) : ");
 	for(unsigned i=0; i<NUM_PORTS; i++)
 	{
 		PRINTN(" "<<i<<"] ");
-		PRINTN(" request: "<<(float)requestPortEmptyCount[i]/(elapsedCycles)*100.0<<"\% idle ");
-		PRINTN(" response: "<<(float)responsePortEmptyCount[i]/(elapsedCycles)*100.0<<"\% idle ");
+		//busy cycles are counted when a packet starts, so one straddling the epoch boundary can push idle time below zero
+		unsigned requestIdle = elapsedCycles - min(requestPortBusyCount[i], elapsedCycles);
+		unsigned responseIdle = elapsedCycles - min(responsePortBusyCount[i], elapsedCycles);
+		PRINTN(" request: "<<(float)requestIdle/(elapsedCycles)*100.0<<"\% idle ");
+		PRINTN(" response: "<<(float)responseIdle/(elapsedCycles)*100.0<<"\% idle ");
 		PRINTN(" rds:"<<readsPerPort[i]);
 		PRINTN(" wrts:"<<writesPerPort[i]);
 		PRINTN(" rtn:"<<returnsPerPort[i]);
+		PRINTN(" lat:"<<(returnsPerPort[i]==0 ? 0 : CPU_CLK_PERIOD*latencyPerPort[i]/returnsPerPort[i])<<"ns");
 		PRINT(" tot:"<<requestCounterPerPort[i]);
 
 		//clear
 		returnsPerPort[i]=0;
+		latencyPerPort[i]=0;
 		writesPerPort[i]=0;
 		readsPerPort[i]=0;
-		responsePortEmptyCount[i]=0;
-		requestPortEmptyCount[i]=0;
+		responsePortBusyCount[i]=0;
+		requestPortBusyCount[i]=0;
 		requestCounterPerPort[i]=0;
 	}
 
+	PrintLogicStats(elapsedCycles);
+
 	issuedWrites = 0;
 	returnedReads = 0;
 	fullSum = 0;
@@ -713,6 +910,72 @@ void BOBWrapper::PrintStats(bool finalPrint)
 	bob->PrintStats(statsOut, powerOut, finalPrint, elapsedCycles);
 }
 
+//Latency of the logic ops returned this epoch and the DRAM traffic and link bytes of the ops
+//  started, by logic type - only printed in epochs with logic ops
+void BOBWrapper::PrintLogicStats(unsigned elapsedCycles)
+{
+	map<unsigned, LogicTypeStats> totals;
+	for(unsigned i=0; i<NUM_CHANNELS; i++)
+	{
+		map<unsigned, LogicTypeStats> &typeStats = bob->channels[i]->logicLayer->typeStats;
+		for(map<unsigned, LogicTypeStats>::iterator it=typeStats.begin(); it!=typeStats.end(); it++)
+		{
+			LogicTypeStats &total = totals[it->first];
+			total.started += it->second.started;
+			total.reads += it->second.reads;
+			total.writes += it->second.writes;
+			total.readBytes += it->second.readBytes;
+			total.writeBytes += it->second.writeBytes;
+			total.linkBytes += it->second.linkBytes;
+		}
+		typeStats.clear();
+	}
+	for(map<unsigned, vector<unsigned> >::iterator it=logicLatencies.begin(); it!=logicLatencies.end(); it++)
+	{
+		totals[it->first];
+	}
+
+	if(totals.empty()) return;
+
+	//link bytes saved compare the ops' packets with the CPU doing each of their DRAM requests itself
+	PRINT(" ---  Logic operations (per epoch) : ");
+	PRINT("   type               started  returned   mean(ns)    min(ns)    p50(ns)    p95(ns)    max(ns)     rd/op     wr/op   DRAM GB/s   link bytes saved");
+	for(map<unsigned, LogicTypeStats>::iterator it=totals.begin(); it!=totals.end(); it++)
+	{
+		LogicTypeStats &stats = it->second;
+		vector<unsigned> &latencies = logicLatencies[it->first];
+		sort(latencies.begin(), latencies.end());
+
+		double mean = 0;
+		for(unsigned i=0; i<latencies.size(); i++)
+		{
+			mean += latencies[i];
+		}
+		mean = latencies.empty() ? 0 : mean/latencies.size();
+		unsigned minLat = latencies.empty() ? 0 : latencies[0];
+		unsigned p50 = latencies.empty() ? 0 : latencies[latencies.size()/2];
+		unsigned p95 = latencies.empty() ? 0 : latencies[(latencies.size()*95)/100];
+		unsigned maxLat = latencies.empty() ? 0 : latencies.back();
+
+		int64_t cpuBytes = stats.reads*(RD_REQUEST_PACKET_OVERHEAD + RD_RESPONSE_PACKET_OVERHEAD) + stats.readBytes +
+		                   stats.writes*WR_REQUEST_PACKET_OVERHEAD + stats.writeBytes;
+
+		stringstream name;
+		name<<LogicOperation::TypeName(it->first);
+		if(it->first>=LogicOperation::FIRST_USER_LOGIC_TYPE) name<<" "<<it->first;
+
+		PRINT("   "<<left<<setw(17)<<name.str()<<right<<setw(9)<<stats.started<<setw(10)<<latencies.size()<<
+		      setw(11)<<mean*CPU_CLK_PERIOD<<setw(11)<<minLat*CPU_CLK_PERIOD<<setw(11)<<p50*CPU_CLK_PERIOD<<
+		      setw(11)<<p95*CPU_CLK_PERIOD<<setw(11)<<maxLat*CPU_CLK_PERIOD<<
+		      setw(10)<<(stats.started==0 ? 0 : (float)stats.reads/stats.started)<<
+		      setw(10)<<(stats.started==0 ? 0 : (float)stats.writes/stats.started)<<
+		      setw(12)<<(float)(stats.readBytes+stats.writeBytes)/(elapsedCycles*CPU_CLK_PERIOD)<<
+		      setw(19)<<cpuBytes-(int64_t)stats.linkBytes);
+	}
+
+	logicLatencies.clear();
+}
+
 void BOBWrapper::WriteIssuedCallback(unsigned port, uint64_t address)
 {
 	committedWrites++;
@@ -32,11 +32,13 @@
 #define BOBWRAPPER_H
 
 #include <deque>
+#include <map>
 #include "SimulatorObject.h"
 #include "BOB.h"
 #include <math.h>
 #include "Callback.h"
 #include "Transaction.h"
+#include "LogicOperationHandler.h"
 
 
 using namespace std;
@@ -59,8 +61,10 @@ public:
 	    TransactionCompleteCB *writeDone,
 	    LogicOperationCompleteCB *logicDone);
 	void PrintStats(bool finalPrint);
+	void PrintLogicStats(unsigned elapsedCycles);
 	void UpdateLatencyStats(Transaction *trans);
-	int FindOpenPort(uint coreID);
+	int FindOpenPort(uint coreID, uint64_t addr=0);
+	int LeastLoadedPort(vector<Bitmap> &portsAtLevel, unsigned firstPort, unsigned numPorts);
 	bool isPortAvailable(unsigned port);
 
 	//Fields
@@ -85,12 +89,13 @@ public:
 	uint64_t writesPerCycle;
 
 	//Bookkeeping and statistics
-	vector<unsigned> requestPortEmptyCount;
-	vector<unsigned> responsePortEmptyCount;
+	vector<unsigned> requestPortBusyCount;
+	vector<unsigned> responsePortBusyCount;
 	vector<unsigned> requestCounterPerPort;
 	vector<unsigned> readsPerPort;
 	vector<unsigned> writesPerPort;
 	vector<unsigned> returnsPerPort;
+	vector<uint64_t> latencyPerPort;
 
 	//Callback functions
 	TransactionCompleteCB *readDoneCallback;
@@ -116,6 +121,9 @@ public:
 	vector<unsigned> chanLatencies;
 	unsigned chanSum;
 
+	//Full latency of each logic op returned this epoch, by logic type
+	map<unsigned, vector<unsigned> > logicLatencies;
+
 	unsigned issuedLogicOperations;
 	unsigned issuedWrites;
 	unsigned committedWrites;
@@ -134,10 +142,26 @@ public:
 	
 	//Round-robin counter
 	uint portRoundRobin;
+	//Ports in the middle of receiving a request or sending a response
+	Bitmap portsReceiving;
+	Bitmap portsSending;
 
 };
 BOBWrapper *getMemorySystemInstance(uint64_t qemu_mem_size);
 void *getPageWalkLogicOp(uint64_t baseAddr, vector<uint64_t> *args);
+void *getReduceLogicOp(uint64_t numLines, unsigned reduceFunction);
+void *getGatherLogicOp(unsigned elementSize, vector<uint64_t> *indices);
+void *getScatterLogicOp(unsigned elementSize, vector<uint64_t> *indices);
+void *getAtomicAddLogicOp(uint64_t value);
+void *getAtomicCASLogicOp(uint64_t expected, uint64_t desired);
+void *getAtomicSwapLogicOp(uint64_t value);
+void *getChaseLogicOp(uint64_t maxHops, unsigned nextOffset, vector<uint64_t> *nodes);
+void *getLogicOp(unsigned logicType, vector<uint64_t> *args, unsigned requestPayload, unsigned resultSize);
+void registerLogicOpHandler(unsigned logicType, LogicOperationHandler *handler);
+uint64_t getLogicOpResult(void *logicOp);
+unsigned getLogicOpType(void *logicOp);
+vector<uint64_t> &getLogicOpArguments(void *logicOp);
+void setLogicOpResult(void *logicOp, uint64_t result);
 }
 
 
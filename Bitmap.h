@@ -0,0 +1,120 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef BITMAP_H
+#define BITMAP_H
+
+//Bitmap header - fixed size set of bits with fast search for the next set bit
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+using std::vector;
+namespace BOBSim
+{
+class Bitmap
+{
+public:
+	//Functions
+	Bitmap() : numBits(0) {}
+	Bitmap(unsigned size) : numBits(size), words((size+63)/64, 0) {}
+
+	void Set(unsigned i)
+	{
+		words[i>>6] |= (1ULL << (i&63));
+	}
+	void Clear(unsigned i)
+	{
+		words[i>>6] &= ~(1ULL << (i&63));
+	}
+	bool Test(unsigned i) const
+	{
+		return (words[i>>6] >> (i&63)) & 1;
+	}
+	bool Any() const
+	{
+		for(unsigned w=0; w<words.size(); w++)
+		{
+			if(words[w]) return true;
+		}
+		return false;
+	}
+
+	//Returns the first set bit at or after start, or -1 if there are none
+	int FindNextSet(unsigned start) const
+	{
+		return Search(start, NULL, NULL);
+	}
+
+	//Same, but skips bits which are also set in the exclude map(s) (which must be the same size)
+	int FindNextSet(unsigned start, const Bitmap &exclude) const
+	{
+		return Search(start, &exclude, NULL);
+	}
+	int FindNextSet(unsigned start, const Bitmap &exclude1, const Bitmap &exclude2) const
+	{
+		return Search(start, &exclude1, &exclude2);
+	}
+
+	//Fields
+	unsigned numBits;
+	vector<uint64_t> words;
+
+private:
+	uint64_t Word(unsigned w, const Bitmap *exclude1, const Bitmap *exclude2) const
+	{
+		uint64_t word = words[w];
+		if(exclude1) word &= ~exclude1->words[w];
+		if(exclude2) word &= ~exclude2->words[w];
+		return word;
+	}
+
+	int Search(unsigned start, const Bitmap *exclude1, const Bitmap *exclude2) const
+	{
+		if(start>=numBits) return -1;
+
+		unsigned w = start>>6;
+		uint64_t word = Word(w, exclude1, exclude2) & (~0ULL << (start&63));
+		while(true)
+		{
+			if(word)
+			{
+				unsigned bit = (w<<6) + __builtin_ctzll(word);
+				return bit<numBits ? (int)bit : -1;
+			}
+			if(++w==words.size()) return -1;
+			word = Word(w, exclude1, exclude2);
+		}
+	}
+};
+}
+
+#endif
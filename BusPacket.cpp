@@ -47,7 +47,8 @@ BusPacket::BusPacket():
 	burstLength(0),
 	queueWaitTime(0),
 	channel(0),
-	fromLogicOp(false)
+	fromLogicOp(false),
+	isPrefetch(false)
 {}
 
 BusPacket::BusPacket(BusPacketType packtype, unsigned id, unsigned col, unsigned rw, unsigned rnk, unsigned bnk, unsigned prt, unsigned bl, unsigned mappedChannel, uint64_t addr, bool fromLogic):
@@ -62,7 +63,8 @@ BusPacket::BusPacket(BusPacketType packtype, unsigned id, unsigned col, unsigned
 	channel(mappedChannel),
 	queueWaitTime(0),
 	address(addr),
-	fromLogicOp(fromLogic)
+	fromLogicOp(fromLogic),
+	isPrefetch(false)
 {}
 
 void BusPacket::PrintVerification(uint64_t currentCycle)
@@ -63,6 +63,8 @@ public:
 
 	//Fields
 	bool fromLogicOp;
+	//Read issued by the prefetcher rather than a request
+	bool isPrefetch;
 	BusPacketType busPacketType;
 	unsigned column;
 	unsigned row;
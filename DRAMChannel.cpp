@@ -32,6 +32,7 @@
 
 #include "DRAMChannel.h"
 #include "LogicLayerInterface.h"
+#include <algorithm>
 
 using namespace std;
 using namespace BOBSim;
@@ -58,7 +59,12 @@ DRAMChannel::DRAMChannel(unsigned id, Callback<BOB, void, BusPacket*, unsigned>
 	readReturnQueueMax(0),
 	simpleController(this),
 	logicLayer(NULL),
-	DRAMBusIdleCount(0)
+	pendingLogicResponse(NULL),
+	DRAMBusIdleCount(0),
+	demandReads(0),
+	prefetchHits(0),
+	prefetchLateHits(0),
+	prefetchesUnused(0)
 {
 	ReportCallback = reportCB;
 
@@ -123,25 +129,25 @@ void DRAMChannel::Update()
 			case READ_DATA:
 				if(DEBUG_CHANNEL) DEBUG("     == Data burst complete : " << *inFlightDataPacket);
 
+				//prefetched data goes to the prefetch buffer
+				if(inFlightDataPacket->isPrefetch)
+				{
+					PrefetchArrived(inFlightDataPacket);
+				}
 				//if the bus packet was from a request originating from a logic operation, send it back to logic layer
-				if(inFlightDataPacket->fromLogicOp)
+				else if(inFlightDataPacket->fromLogicOp)
 				{
-					(*SendToLogicLayer)(new Transaction(RETURN_DATA, 64, inFlightDataPacket->address),0);
+					//tagged with the read's ID so the logic layer knows which op it belongs to
+					Transaction *data = new Transaction(RETURN_DATA, 64, inFlightDataPacket->address);
+					data->transactionID = inFlightDataPacket->transactionID;
+					(*SendToLogicLayer)(data,0);
 				}
 				//if it was a regular request, add to return queue
 				else
 				{
-					readReturnQueue.push_back(inFlightDataPacket);
-
 					simpleController.outstandingReads--;
 
-					(*ReportCallback)(inFlightDataPacket, 0);
-
-					//keep track of total number of entries in return queue
-					if(readReturnQueue.size()>readReturnQueueMax)
-					{
-						readReturnQueueMax = readReturnQueue.size();
-					}
+					ReturnReadData(inFlightDataPacket);
 				}
 				break;
 			case WRITE_DATA:
@@ -180,6 +186,12 @@ bool DRAMChannel::AddTransaction(Transaction *trans, unsigned notused)
 	{
 		if(SendToLogicLayer!=NULL)
 		{
+			//BOB only sends a logic op when the logic layer has room for it
+			if(logicLayer->pendingLogicOpsQueue.size()>=LOGIC_OP_QUEUE_DEPTH)
+			{
+				ERROR("== ERROR - Logic layer "<<channelID<<" got a logic operation with a full queue : "<<*trans);
+				exit(0);
+			}
 			(*SendToLogicLayer)(trans,0);
 		}
 		else
@@ -201,6 +213,21 @@ bool DRAMChannel::AddTransaction(Transaction *trans, unsigned notused)
 	{
 		if(simpleController.waitingACTS<CHANNEL_WORK_Q_MAX)
 		{
+			if(ENABLE_PREFETCHING && !trans->originatedFromLogicOp)
+			{
+				if(trans->transactionType==DATA_READ)
+				{
+					demandReads++;
+					bool prefetched = ReadFromPrefetchBuffer(trans);
+					simpleController.TrainPrefetcher(trans->address);
+					if(prefetched) return true;
+				}
+				else if(trans->transactionType==DATA_WRITE)
+				{
+					InvalidatePrefetch(trans->address / CACHE_LINE_SIZE);
+				}
+			}
+
 			simpleController.AddTransaction(trans);
 		}
 		else return false;
@@ -209,6 +236,128 @@ bool DRAMChannel::AddTransaction(Transaction *trans, unsigned notused)
 	return true;
 }
 
+//Puts response data in the return queue (space for it was reserved when the read issued)
+void DRAMChannel::ReturnReadData(BusPacket *readData)
+{
+	readReturnQueue.push_back(readData);
+
+	(*ReportCallback)(readData, 0);
+
+	//keep track of total number of entries in return queue
+	if(readReturnQueue.size()>readReturnQueueMax)
+	{
+		readReturnQueueMax = readReturnQueue.size();
+	}
+}
+
+//Answers a read from the prefetch buffer, or has it wait for a prefetch of its line which
+//  is already under way.  Returns false if the read has to go to DRAM.
+bool DRAMChannel::ReadFromPrefetchBuffer(Transaction *trans)
+{
+	uint64_t line = trans->address / CACHE_LINE_SIZE;
+
+	//the data still needs a place in the return queue
+	if(simpleController.returnQueueReserved + TRANSACTION_SIZE > CHANNEL_RETURN_Q_MAX)
+	{
+		return false;
+	}
+
+	deque<uint64_t>::iterator it = find(prefetchBuffer.begin(), prefetchBuffer.end(), line);
+	bool inFlight = it==prefetchBuffer.end() &&
+	                find(prefetchesInFlight.begin(), prefetchesInFlight.end(), line)!=prefetchesInFlight.end();
+	if(it==prefetchBuffer.end() && !inFlight)
+	{
+		return false;
+	}
+
+	//a prefetch that hasn't started would only make the read wait behind demand requests
+	if(inFlight && simpleController.CancelPrefetch(line))
+	{
+		prefetchesInFlight.erase(find(prefetchesInFlight.begin(), prefetchesInFlight.end(), line));
+		return false;
+	}
+
+	if(DEBUG_CHANNEL) DEBUG("     == Prefetch "<<(inFlight ? "in flight for " : "hit for ")<<*trans);
+	simpleController.returnQueueReserved += TRANSACTION_SIZE;
+	BusPacket *readData = new BusPacket(READ_DATA,trans->transactionID,0,0,0,0,trans->portID,0,channelID,trans->address,false);
+
+	if(inFlight)
+	{
+		prefetchLateHits++;
+		prefetchWaiters.push_back(readData);
+	}
+	else
+	{
+		prefetchHits++;
+		prefetchBuffer.erase(it);
+		ReturnReadData(readData);
+	}
+	return true;
+}
+
+//Prefetched data came off the data bus - hand it to any reads waiting on it or keep it
+void DRAMChannel::PrefetchArrived(BusPacket *readData)
+{
+	uint64_t line = readData->address / CACHE_LINE_SIZE;
+
+	bool used = false;
+	for(unsigned i=0; i<prefetchWaiters.size(); )
+	{
+		if(prefetchWaiters[i]->address / CACHE_LINE_SIZE == line)
+		{
+			ReturnReadData(prefetchWaiters[i]);
+			prefetchWaiters.erase(prefetchWaiters.begin()+i);
+			used = true;
+		}
+		else i++;
+	}
+
+	//a write to the line while it was being read means the data can't be kept
+	vector<uint64_t>::iterator it = find(prefetchesInFlight.begin(), prefetchesInFlight.end(), line);
+	if(it!=prefetchesInFlight.end())
+	{
+		prefetchesInFlight.erase(it);
+		if(!used)
+		{
+			if(prefetchBuffer.size()>=PREFETCH_BUFFER_ENTRIES)
+			{
+				prefetchBuffer.pop_front();
+				prefetchesUnused++;
+			}
+			prefetchBuffer.push_back(line);
+		}
+	}
+	else if(!used)
+	{
+		prefetchesUnused++;
+	}
+
+	delete readData;
+}
+
+//Drops a prefetched (or being prefetched) line that a write is about to change
+void DRAMChannel::InvalidatePrefetch(uint64_t line)
+{
+	deque<uint64_t>::iterator it = find(prefetchBuffer.begin(), prefetchBuffer.end(), line);
+	if(it!=prefetchBuffer.end())
+	{
+		prefetchBuffer.erase(it);
+		prefetchesUnused++;
+	}
+
+	vector<uint64_t>::iterator inFlight = find(prefetchesInFlight.begin(), prefetchesInFlight.end(), line);
+	if(inFlight!=prefetchesInFlight.end())
+	{
+		prefetchesInFlight.erase(inFlight);
+	}
+}
+
+bool DRAMChannel::PrefetchPresent(uint64_t line)
+{
+	return find(prefetchBuffer.begin(), prefetchBuffer.end(), line)!=prefetchBuffer.end() ||
+	       find(prefetchesInFlight.begin(), prefetchesInFlight.end(), line)!=prefetchesInFlight.end();
+}
+
 void DRAMChannel::ReceiveOnCmdBus(BusPacket *busPacket, unsigned id)
 {
 	if(inFlightCommandPacket!=NULL)
@@ -222,7 +371,7 @@ void DRAMChannel::ReceiveOnCmdBus(BusPacket *busPacket, unsigned id)
 	if(DEBUG_CHANNEL) DEBUG("     == Putting command on bus : " << *busPacket);
 
 	//Report the time we waited in the queue
-	if(busPacket->busPacketType==ACTIVATE)
+	if(busPacket->busPacketType==ACTIVATE && !busPacket->isPrefetch)
 	{
 		(*ReportCallback)(busPacket, 0);
 	}
@@ -54,6 +54,11 @@ public:
 	void Update();
 	void ReceiveOnDataBus(BusPacket *busPacket, unsigned ID);
 	void ReceiveOnCmdBus(BusPacket *busPacket, unsigned ID);
+	void ReturnReadData(BusPacket *readData);
+	bool ReadFromPrefetchBuffer(Transaction *trans);
+	void PrefetchArrived(BusPacket *readData);
+	void InvalidatePrefetch(uint64_t line);
+	bool PrefetchPresent(uint64_t line);
 	void RegisterCallback(Callback<BOB, void, BusPacket*, unsigned> *reportCB);
 
 	//Fields
@@ -73,6 +78,18 @@ public:
 	//Storage for pending response data
 	deque<BusPacket*> readReturnQueue;
 	
+	//Prefetched cache lines, oldest first
+	deque<uint64_t> prefetchBuffer;
+	//Cache lines being prefetched
+	vector<uint64_t> prefetchesInFlight;
+	//Data for reads that asked for a line which was still being prefetched
+	vector<BusPacket*> prefetchWaiters;
+	//Bookkeeping for the prefetcher
+	unsigned demandReads;
+	unsigned prefetchHits;
+	unsigned prefetchLateHits;
+	unsigned prefetchesUnused;
+
 	//Callbacks
 	Callback<BOB, void, BusPacket*, unsigned> *ReportCallback;
 	Callback<LogicLayerInterface, void, Transaction*, unsigned> *SendToLogicLayer;
@@ -78,7 +78,18 @@ enum PortHeuristicScheme
 {
 	FIRST_AVAILABLE,
 	ROUND_ROBIN,
-	PER_CORE
+	PER_CORE,
+	LEAST_OCCUPIED,
+	ADDRESS_HASHED,
+	JOIN_SHORTEST_QUEUE
+};
+
+enum ResponseArbitrationScheme
+{
+	RSP_ROUND_ROBIN,
+	RSP_OLDEST_FIRST,
+	RSP_RRQ_OCCUPANCY,
+	RSP_PRIORITY_CLASS
 };
 
 enum AddressMappingScheme
@@ -135,7 +146,7 @@ extern uint64_t QEMU_MEMORY_SIZE;
 //BOB Architecture Config
 //
 //
-//NOTE : NUM_LINK_BUSES * CHANNELS_PER_LINK_BUS = NUM_CHANNELS
+//NOTE : NUM_LINK_BUSES * CHANNELS_PER_LINK_BUS = NUM_CHANNELS (unless LINK_TOPOLOGY is given)
 //
 //Number of link buses in the system
 static uint NUM_LINK_BUSES = 4;
@@ -144,10 +155,28 @@ static uint NUM_CHANNELS = 8;
 //Multi-channel optimization degree
 static uint CHANNELS_PER_LINK_BUS = 2;
 
+//Which channels hang off which link bus (set at runtime) - empty means CHANNELS_PER_LINK_BUS
+//  consecutive channels on each link bus, all on one simple controller.
+//  Link buses are separated by ';', the buffers daisy-chained along a link bus by '>' and the
+//  channels on a buffer by ','. A buffer after the first may end in @latency or
+//  @latency/requestLanes/responseLanes to set the hop that forwards to it.
+//  e.g. "0,1>2,3@24;4,5;6;7" - link bus 0 forwards through channels 0 and 1's buffer to
+//  the buffer with 2 and 3, and link buses 2 and 3 have one channel each
+extern std::string LINK_TOPOLOGY;
+//Defaults for the hop between daisy-chained buffers
+static uint DAISY_CHAIN_HOP_LATENCY = 12; //CPU clock cycles
+static uint DAISY_CHAIN_HOP_REQUEST_LANES = 8;
+static uint DAISY_CHAIN_HOP_RESPONSE_LANES = 12;
+//Responses each daisy-chained buffer can forward ahead of the one being sent on the link bus
+static uint DAISY_CHAIN_FORWARD_DEPTH = 2;
+
 //Number of lanes for both request and response link bus
 static uint REQUEST_LINK_BUS_WIDTH = 8;//Bit Lanes
 static uint RESPONSE_LINK_BUS_WIDTH = 12; //Bit Lanes
 
+//Number of packets each SerDes buffer can hold (not counting the packet on the link bus)
+static uint SERDES_BUFFER_DEPTH = 4;
+
 //Clock frequency for link buses
 //static float LINK_BUS_CLK_PERIOD = .15625; // ns - 6.4 GHz
 static float LINK_BUS_CLK_PERIOD = .3125; // ns - 3.2 GHz
@@ -156,6 +185,30 @@ extern uint LINK_CPU_CLK_RATIO;
 //Flag to turn on/off double-data rate transfer on link bus
 static bool LINK_BUS_USE_DDR = true;
 
+//Lets a governor shut down lanes and slow the clock of lightly used link buses
+static bool ENABLE_LINK_DVFS = false;
+//How often the governor looks at link utilization
+static uint LINK_GOVERNOR_INTERVAL = 2000; //CPU clock cycles
+//Utilization (busiest direction) below which the link steps down and above which it steps up
+static float LINK_DVFS_LOW_UTILIZATION = 0.3;
+static float LINK_DVFS_HIGH_UTILIZATION = 0.7;
+//Lowest settings a link can step down to - lanes are halved first, then the clock is divided
+static uint LINK_DVFS_MAX_LANE_SHIFT = 2; //down to 1/4 of the lanes
+static uint LINK_DVFS_MAX_CLOCK_DIVIDER = 4;
+//Time the link is unusable while lanes retrain after a change
+static uint LINK_RECONFIG_LATENCY = 200; //CPU clock cycles
+
+//Lets each link bus move lanes between its request and response directions
+//  (the total is REQUEST_LINK_BUS_WIDTH + RESPONSE_LINK_BUS_WIDTH). Checked every LINK_GOVERNOR_INTERVAL.
+static bool ENABLE_LANE_REBALANCING = false;
+//How much a move has to lower the busier direction's utilization before lanes are moved
+static float LANE_REBALANCE_HYSTERESIS = 0.1;
+//Lanes moved at a time and fewest lanes a direction can be left with
+static uint LANE_REBALANCE_STEP = 2;
+static uint LANE_REBALANCE_MIN_LANES = 4;
+//Time the link is unusable while lanes switch direction
+static uint LANE_SWITCH_LATENCY = 400; //CPU clock cycles
+
 //Size of DRAM request
 static uint TRANSACTION_SIZE = 64;
 //Width of DRAM bus as standardized by JEDEC
@@ -167,13 +220,66 @@ extern uint NUM_PORTS;
 static uint PORT_WIDTH = 16;
 //Number of transaction packets that each port buffer may hold
 static uint PORT_QUEUE_DEPTH = 8;
-//Heuristic used for adding new requests to the available ports
-static PortHeuristicScheme portHeuristic = FIRST_AVAILABLE;
+//Heuristic used for adding new requests to the available ports (set at runtime)
+//  LEAST_OCCUPIED      - port with the fewest requests in its input buffer
+//  ADDRESS_HASHED      - port picked by the channel the address maps to (or the least occupied
+//                        port in the core's set of ports if that one is busy)
+//  JOIN_SHORTEST_QUEUE - port with the fewest requests in its input buffer or waiting on a response
+extern PortHeuristicScheme portHeuristic;
+//Port loads above this are all treated the same by JOIN_SHORTEST_QUEUE
+static uint PORT_LOAD_LEVELS = 32;
+
+//A read to a cache line which already has a read outstanding waits for that read's data
+//  instead of making its own trip to DRAM (up to READ_COALESCING_MAX_WAITERS per read)
+static bool ENABLE_READ_COALESCING = true;
+static uint READ_COALESCING_MAX_WAITERS = 8;
+
+//Keeps recently read lines on the main BOB controller so reads to them are answered
+//  without going over the link buses to DRAM
+static bool ENABLE_READ_BUFFER = false;
+static uint READ_BUFFER_SIZE = 256*1024; //bytes
+static uint READ_BUFFER_ASSOCIATIVITY = 8;
+//Time to answer a read from the buffer
+static uint READ_BUFFER_LATENCY = 4; //CPU clock cycles
+//Writes to buffered lines update them (true) or invalidate them (false)
+static bool READ_BUFFER_WRITE_THROUGH = true;
 
 //Number of requests each simple controller can hold in its work queue
 static uint CHANNEL_WORK_Q_MAX = 16; //entries
 //Amount of response data that can be held in each simple controller return queue
 static uint CHANNEL_RETURN_Q_MAX = 1024; //bytes
+//Reads reserve return queue space when they issue, so writes do not need to wait on it.
+//  Set to true to get the old behavior where a full return queue also holds up writes
+static bool RRQ_FULL_BLOCKS_WRITES = false;
+//Merges writes to a cache line that already has a write waiting in the work queue and
+//  answers reads to that line from the queued write instead of going to DRAM
+static bool ENABLE_WRITE_COMBINING = true;
+
+//Stride prefetcher in each simple controller - reads ahead of streams it sees into a small
+//  prefetch buffer in the channel, using only command slots that demand requests leave empty
+static bool ENABLE_PREFETCHING = false;
+//Streams tracked per channel and largest stride (in cache lines) that is followed
+static uint PREFETCH_STREAMS = 8;
+static uint PREFETCH_MAX_STRIDE = 16;
+//Number of times in a row a stride has to be seen before prefetching starts
+static uint PREFETCH_CONFIDENCE = 2;
+//How many lines ahead of a stream are kept prefetched
+static uint PREFETCH_DEGREE = 4;
+//Prefetches that can be waiting to issue and lines the prefetch buffer holds (per channel)
+static uint PREFETCH_QUEUE_MAX = 8;
+static uint PREFETCH_BUFFER_ENTRIES = 16;
+
+//How channels sharing a link bus take turns sending responses
+//  RSP_ROUND_ROBIN    - next channel in line with something to send
+//  RSP_OLDEST_FIRST   - response whose request entered BOB first
+//  RSP_RRQ_OCCUPANCY  - channel with the most data in its return queue
+//  RSP_PRIORITY_CLASS - lowest class (coreID / CORES_PER_PRIORITY_CLASS), oldest first within a class
+static ResponseArbitrationScheme responseArbitration = RSP_ROUND_ROBIN;
+static uint CORES_PER_PRIORITY_CLASS = 1;
+static uint NUM_PRIORITY_CLASSES = 4;
+//Bins for the per-channel histogram of time spent waiting in the return queue
+static uint RESPONSE_WAIT_HISTOGRAM_BIN_SIZE = 64; //cycles
+static uint RESPONSE_WAIT_HISTOGRAM_BINS = 16; //last bin holds everything larger
 
 //
 //Logic Layer Stuff
@@ -182,6 +288,30 @@ static uint CHANNEL_RETURN_Q_MAX = 1024; //bytes
 static bool GIVE_LOGIC_PRIORITY = true;
 //Size of logic request packet
 static uint LOGIC_RESPONSE_PACKET_OVERHEAD = 8;
+//PAGE_FILL sends its lines as one write and the simple controller opens each row once and
+//  streams all of the row's column writes (otherwise every line is its own ACTIVATE + WRITE_P)
+static bool PAGE_FILL_ROW_BURSTS = true;
+//Number of logic operations each channel's logic layer works on at once
+static uint LOGIC_OPERATION_CONTEXTS = 4;
+//Depth of each logic layer's queues - logic ops waiting for a context (BOB only sends one to a
+//  channel when it has room for it), requests and responses waiting to go to the channel or
+//  over the side-band path (one spot is kept for each context's response, so this has to be
+//  more than LOGIC_OPERATION_CONTEXTS), and reads out at once (which bounds the data coming back)
+static uint LOGIC_OP_QUEUE_DEPTH = 8;
+static uint LOGIC_OUTGOING_QUEUE_DEPTH = 32;
+static uint LOGIC_RETURN_QUEUE_DEPTH = 32;
+//Cycles (DRAM clock) the logic layer's ALU spends folding each line into a REDUCE result
+static uint LOGIC_REDUCE_ALU_LATENCY = 2;
+//Element requests a GATHER keeps in flight at once (and a SCATTER sends per cycle)
+static uint LOGIC_GATHER_PARALLELISM = 8;
+//Atomics are a read-modify-write of one 8-byte word in the logic layer - atomics to lines which
+//  share a lock table entry (line % LOGIC_ATOMIC_LOCK_ENTRIES) go one at a time
+static uint LOGIC_ATOMIC_LOCK_ENTRIES = 64;
+static uint LOGIC_ATOMIC_LATENCY = 1; //DRAM cycles for the modify step
+//Side-band path logic layers use to move data to another channel (e.g., a copy whose
+//  destination is in another channel) - shared by all channels
+static uint LOGIC_TRANSFER_WIDTH = 16; //bytes per CPU cycle
+static uint LOGIC_TRANSFER_LATENCY = 8; //CPU cycles, plus the latency of each daisy chain hop crossed
 
 //
 //Packet sizes
@@ -191,6 +321,25 @@ static uint RD_REQUEST_PACKET_OVERHEAD = 8; //bytes
 static uint RD_RESPONSE_PACKET_OVERHEAD = 8; //bytes
 static uint WR_REQUEST_PACKET_OVERHEAD = 8; //bytes
 
+//Compresses write and read data on the link buses
+static bool ENABLE_LINK_COMPRESSION = false;
+//Compressibility of data which does not have a compressed size set already
+//  (a percentage of lines are all zeros, the rest are uniform between min and max size)
+static uint COMPRESSION_ZERO_LINE_PERCENT = 20;
+static uint COMPRESSED_ZERO_LINE_SIZE = 1; //bytes
+static uint COMPRESSED_MIN_SIZE = 16; //bytes
+static uint COMPRESSED_MAX_SIZE = 64; //bytes
+static uint COMPRESSION_RANDOM_SEED = 1234;
+//Time to compress a packet before it goes on the link bus and decompress it on the other side
+static uint COMPRESSOR_LATENCY = 2; //CPU clock cycles
+static uint DECOMPRESSOR_LATENCY = 2; //CPU clock cycles
+
+//Maximum number of reads that can be packed into one request packet (1 turns coalescing off)
+static uint REQUEST_COALESCING_MAX = 4;
+//A multi-request packet is a header plus a compact descriptor for each read
+static uint COALESCED_REQUEST_HEADER = 4; //bytes
+static uint COALESCED_REQUEST_DESCRIPTOR = 4; //bytes
+
 //
 //CPU
 //
@@ -204,6 +353,11 @@ static float CPU_CLK_PERIOD = 0.3125; //ns
 static uint SIMP_CONT_BACKGROUND_POWER = 7;//watts
 //Additional power consumption for each simple controller core in the package
 static float SIMP_CONT_CORE_POWER = 3.5;//watts
+//Power of each link bus lane when it is sending, when it is on but idle, and when it is shut down
+//  (sending and idle power are for the full link clock and scale down with the clock divider)
+static float LINK_LANE_ACTIVE_POWER = 0.040;//watts
+static float LINK_LANE_IDLE_POWER = 0.030;//watts
+static float LINK_LANE_OFF_POWER = 0.001;//watts
 
 //
 //DRAM Stuff
@@ -34,13 +34,139 @@ using namespace BOBSim;
 using namespace std;
 
 LogicLayerInterface::LogicLayerInterface(uint id):
+	FindChannel(NULL),
+	ReportWrite(NULL),
+	FindLayer(NULL),
 	simpleControllerID(id),
 	currentClockCycle(0),
-	currentTransaction(NULL),
-	currentLogicOperation(NULL),
-	issuedRequests(0)
+	activeContexts(0),
+	aluFreeCycle(0),
+	opsStarted(0),
+	opsCompleted(0),
+	opLatencyTotal(0),
+	activeContextCycles(0),
+	statCycles(0),
+	reducesCompleted(0),
+	linesReduced(0),
+	atomicsCompleted(0),
+	atomicLatencyTotal(0),
+	lockWaitCycles(0),
+	chasesCompleted(0),
+	remoteReadsSent(0),
+	chaseHops(0),
+	hopLatencyTotal(0),
+	pendingOpsOccupancy(0),
+	outgoingOccupancy(0),
+	readsOutOccupancy(0),
+	pendingOpsMax(0),
+	outgoingMax(0),
+	readsOutMax(0)
 {
+	if(LOGIC_OPERATION_CONTEXTS==0)
+	{
+		ERROR("== ERROR - The logic layer needs at least one logic operation context");
+		exit(0);
+	}
+	//every context keeps a spot in the outgoing queue for its response
+	if(LOGIC_OUTGOING_QUEUE_DEPTH<=LOGIC_OPERATION_CONTEXTS)
+	{
+		ERROR("== ERROR - LOGIC_OUTGOING_QUEUE_DEPTH ("<<LOGIC_OUTGOING_QUEUE_DEPTH<<") needs to be more than LOGIC_OPERATION_CONTEXTS ("<<LOGIC_OPERATION_CONTEXTS<<")");
+		exit(0);
+	}
+
+	LogicContext freeContext;
+	freeContext.transaction = NULL;
+	freeContext.logicOperation = NULL;
+	freeContext.issuedRequests = 0;
+	freeContext.returnedRequests = 0;
+	freeContext.pendingTransfers = 0;
+	freeContext.nextElement = 0;
+	freeContext.startCycle = 0;
+	freeContext.responseCycle = 0;
+	freeContext.hopCycle = 0;
+	freeContext.lockEntry = -1;
+	contexts.resize(LOGIC_OPERATION_CONTEXTS, freeContext);
+
+	lockTable = vector<bool>(max(LOGIC_ATOMIC_LOCK_ENTRIES, 1u), false);
+}
+
+map<unsigned, LogicOperationHandler *> LogicLayerInterface::handlers;
+
+//Lets a handler act for the op in one context of a logic layer
+class ContextActions : public LogicOperationActions
+{
+public:
+	ContextActions(LogicLayerInterface *logic, unsigned c) : logic(logic), c(c) {}
+
+	bool CanSend(bool read)
+	{
+		return logic->CanSend(read);
+	}
+	void Read(uint64_t address)
+	{
+		logic->SendRead(c, new Transaction(DATA_READ, 64, address & ~(uint64_t)(CACHE_LINE_SIZE-1)));
+	}
+	void Write(uint64_t address)
+	{
+		logic->SendWrite(c, new Transaction(DATA_WRITE, 64, address & ~(uint64_t)(CACHE_LINE_SIZE-1)));
+	}
+	void Respond(unsigned aluCycles)
+	{
+		logic->RespondAfterALU(c, aluCycles);
+	}
+	uint64_t ReadWord(uint64_t address)
+	{
+		return logic->ReadWord(address);
+	}
+	void WriteWord(uint64_t address, uint64_t value)
+	{
+		logic->WriteWord(address, value);
+	}
+
+	LogicLayerInterface *logic;
+	unsigned c;
+};
 
+//Has handler carry out every logic op of type logicType (which can't be one of the built-in types)
+void LogicLayerInterface::RegisterHandler(unsigned logicType, LogicOperationHandler *handler)
+{
+	if(logicType<LogicOperation::FIRST_USER_LOGIC_TYPE || handler==NULL)
+	{
+		ERROR("== ERROR - Logic operation handlers need a type from "<<LogicOperation::FIRST_USER_LOGIC_TYPE<<" up (got "<<logicType<<")");
+		exit(0);
+	}
+
+	handlers[logicType] = handler;
+}
+
+//The registered handler for op's type (NULL for built-in types)
+LogicOperationHandler *LogicLayerInterface::HandlerFor(LogicOperation *op)
+{
+	if(op->logicType<LogicOperation::FIRST_USER_LOGIC_TYPE)
+	{
+		return NULL;
+	}
+
+	map<unsigned, LogicOperationHandler *>::iterator it = handlers.find(op->logicType);
+	if(it==handlers.end())
+	{
+		ERROR("== ERROR - No handler registered for logic operation type "<<op->logicType);
+		exit(-1);
+	}
+	return it->second;
+}
+
+//Sends back the result of the op in context c once the ALU has spent aluCycles on it
+void LogicLayerInterface::RespondAfterALU(unsigned c, unsigned aluCycles)
+{
+	if(aluCycles==0)
+	{
+		SendResponse(c);
+		return;
+	}
+
+	aluFreeCycle = max(aluFreeCycle, currentClockCycle) + aluCycles;
+	contexts[c].responseCycle = aluFreeCycle;
 }
 
 void LogicLayerInterface::RegisterReturnCallback(Callback<DRAMChannel, bool, Transaction*, unsigned> *returnCallback)
@@ -48,6 +174,21 @@ void LogicLayerInterface::RegisterReturnCallback(Callback<DRAMChannel, bool, Tra
 	ReturnToSimpleController = returnCallback;
 }
 
+void LogicLayerInterface::RegisterChannelCallback(Callback<BOB, unsigned, uint64_t, unsigned> *channelCallback)
+{
+	FindChannel = channelCallback;
+}
+
+void LogicLayerInterface::RegisterWriteCallback(Callback<BOB, void, uint64_t, unsigned> *writeCallback)
+{
+	ReportWrite = writeCallback;
+}
+
+void LogicLayerInterface::RegisterLayerCallback(Callback<BOB, LogicLayerInterface*, uint64_t, unsigned> *layerCallback)
+{
+	FindLayer = layerCallback;
+}
+
 void LogicLayerInterface::ReceiveLogicOperation(Transaction *trans, unsigned i)
 {
 	if (DEBUG_LOGIC) DEBUG("== Received in logic layer "<<simpleControllerID<<" on cycle "<<currentClockCycle<<" : "<<*trans);
@@ -63,212 +204,920 @@ void LogicLayerInterface::ReceiveLogicOperation(Transaction *trans, unsigned i)
 
 void LogicLayerInterface::Update()
 {
-	//send back to channel if there is something in the outgoing queue
-	if(outgoingQueue.size()>0 && (*ReturnToSimpleController)(outgoingQueue[0],0))
+	//send back to channel if there is something in the outgoing queue (the channel deletes writes
+	//  it takes, so look at the type before handing it over)
+	Transaction *outgoing = outgoingQueue.size()>0 ? outgoingQueue[0] : NULL;
+	bool isResponse = outgoing!=NULL && outgoing->transactionType==LOGIC_RESPONSE;
+	if(outgoing!=NULL && (*ReturnToSimpleController)(outgoing,0))
 	{
-		//if we just send the response, we are done and can clear the current stuff
-		if(outgoingQueue[0]->transactionType==LOGIC_RESPONSE)
+		//if we just send the response, that op is done and its context is free again
+		if(isResponse)
 		{
-			currentTransaction = NULL;
-			currentLogicOperation = NULL;
+			for(unsigned c=0; c<contexts.size(); c++)
+			{
+				if(contexts[c].transaction==outgoing)
+				{
+					opsCompleted++;
+					opLatencyTotal += currentClockCycle - contexts[c].startCycle;
+
+					contexts[c].transaction = NULL;
+					contexts[c].logicOperation = NULL;
+					activeContexts--;
+					break;
+				}
+			}
 		}
 
 		outgoingQueue.erase(outgoingQueue.begin());
 	}
 
-	// if we aren't working on anything and there are logic ops waiting
-	if (currentTransaction == NULL && !pendingLogicOpsQueue.empty())
+	// if there are logic ops waiting, start one in a free context
+	if(!pendingLogicOpsQueue.empty() && activeContexts<contexts.size())
 	{
-		//cast logic operation arguments from transaction
-		if(pendingLogicOpsQueue[0]->logicOpContents != NULL)
+		for(unsigned c=0; c<contexts.size(); c++)
 		{
+			if(contexts[c].transaction==NULL)
+			{
+				StartLogicOperation(c);
+				break;
+			}
+		}
+	}
 
-			//extract logic operation from transaction and grab handle to current operations
-			currentLogicOperation = (LogicOperation *)pendingLogicOpsQueue[0]->logicOpContents;
-			currentTransaction = pendingLogicOpsQueue[0];
+	//if we're getting data, it is from a logic op that generated requests
+	if(!newOperationQueue.empty() && newOperationQueue[0]->transactionType == RETURN_DATA)
+	{
+		ReturnData(newOperationQueue[0]);
+		newOperationQueue.erase(newOperationQueue.begin());
+	}
 
-			if(DEBUG_LOGIC) DEBUG(" == In logic layer "<<simpleControllerID<<" : interpreting transaction "<<*currentTransaction);
+	for(unsigned c=0; c<contexts.size(); c++)
+	{
+		if(contexts[c].transaction==NULL) continue;
 
-			// grabbed the pointers, now we can remove from queue
-			pendingLogicOpsQueue.pop_front();
+		//send back results the ALU has finished - an atomic's write-back also needs room
+		if(contexts[c].responseCycle!=0 && contexts[c].responseCycle<=currentClockCycle)
+		{
+			if(!IsAtomic(contexts[c].logicOperation))
+			{
+				contexts[c].responseCycle = 0;
+				SendResponse(c);
+			}
+			else if(CanSend(false))
+			{
+				contexts[c].responseCycle = 0;
+				CompleteAtomic(c);
+			}
+		}
 
+		//atomics waiting on a line lock (or room for their read) try again
+		if(IsAtomic(contexts[c].logicOperation) && contexts[c].issuedRequests==0 && CanSend(true) && !StartAtomic(c))
+		{
+			lockWaitCycles++;
+		}
+
+		//copy writes that didn't fit go out as room opens up
+		if(contexts[c].waitingWrites.size()>0)
+		{
+			SendWaitingWrites(c);
+			CheckWritesDone(c);
+		}
+
+		//a chase hop that didn't fit goes out as soon as there is room
+		if(contexts[c].logicOperation->logicType==LogicOperation::CHASE && contexts[c].issuedRequests==contexts[c].returnedRequests &&
+		        contexts[c].transaction->transactionType!=LOGIC_RESPONSE && CanSend(true))
+		{
+			SendChaseRead(c);
+		}
 
-			//figure out what to do for each type
-			switch(currentLogicOperation->logicType)
+		//user-defined ops keep going until they respond
+		LogicOperationHandler *handler = HandlerFor(contexts[c].logicOperation);
+		if(handler!=NULL)
+		{
+			if(contexts[c].responseCycle==0 && contexts[c].transaction->transactionType!=LOGIC_RESPONSE)
 			{
-			case LogicOperation::PAGE_FILL:
-				//
-				//Arguments:  1) Number of continuous pages
-				//            2) Pattern to copy
-				//
-				uint64_t pageStart;
-				uint64_t numPages;
-				uint pattern;
-				if(currentLogicOperation->arguments.size()!=2)
-				{
-					ERROR("== ERROR - Incorrect number of arguments for logic operation "<<currentLogicOperation->logicType);
-					exit(-1);
-				}
+				ContextActions actions(this, c);
+				handler->Update(actions, contexts[c].logicOperation);
+			}
+			continue;
+		}
 
-				//get arguments
-				pageStart = currentTransaction->address;
-				numPages = currentLogicOperation->arguments[0];
-				pattern = (uint)currentLogicOperation->arguments[1];
+		//keep gathers and scatters going
+		unsigned type = contexts[c].logicOperation->logicType;
+		if((type==LogicOperation::GATHER || type==LogicOperation::SCATTER) &&
+		        contexts[c].nextElement < contexts[c].logicOperation->arguments.size()-1)
+		{
+			IssueElements(c);
+		}
+		//and ops which go through a range of lines
+		else if(contexts[c].nextElement < LinesToIssue(contexts[c]))
+		{
+			IssueLines(c);
+		}
+	}
 
-				if(DEBUG_LOGIC)
-				{
-					DEBUG("       PAGE FILL");
-					DEBUG("        Start     : "<<pageStart);
-					DEBUG("        Num Pages : "<<numPages);
-					DEBUG("        Fill with : "<<pattern);
-				}
+	pendingOpsOccupancy += pendingLogicOpsQueue.size();
+	outgoingOccupancy += outgoingQueue.size();
+	readsOutOccupancy += requestContexts.size();
+	pendingOpsMax = max(pendingOpsMax, (unsigned)pendingLogicOpsQueue.size());
+	outgoingMax = max(outgoingMax, (unsigned)outgoingQueue.size());
+	readsOutMax = max(readsOutMax, (unsigned)requestContexts.size());
 
-				//generate the writes required to write a pattern to each page
-				for(int i=0; i<numPages; i++)
-				{
-					Transaction *trans = new Transaction(DATA_WRITE, 64, pageStart + i*(1<<(log2(BUS_ALIGNMENT_SIZE)+log2(NUM_CHANNELS))));
-					trans->originatedFromLogicOp = true;
+	activeContextCycles += activeContexts;
+	statCycles++;
+	currentClockCycle++;
+}
 
-					if(DEBUG_LOGIC) DEBUG("      == Logic Op created : "<<*trans);
+//Takes the logic op at the head of the pending queue and works on it in context c
+void LogicLayerInterface::StartLogicOperation(unsigned c)
+{
+	LogicContext &context = contexts[c];
 
-					outgoingQueue.push_back(trans);
+	//cast logic operation arguments from transaction
+	if(pendingLogicOpsQueue[0]->logicOpContents == NULL)
+	{
+		ERROR(" == Error - Logic operation has no contents : "<<*pendingLogicOpsQueue[0]);
+		exit(-1);
+	}
 
-					//pattern not used lol :(
-				}
+	//extract logic operation from transaction and grab handle to it
+	context.logicOperation = (LogicOperation *)pendingLogicOpsQueue[0]->logicOpContents;
+	context.transaction = pendingLogicOpsQueue[0];
+	context.issuedRequests = 0;
+	context.returnedRequests = 0;
+	context.pendingTransfers = 0;
+	context.nextElement = 0;
+	context.lockEntry = -1;
+	context.startCycle = currentClockCycle;
+	context.responseCycle = 0;
+	context.hopCycle = 0;
+	activeContexts++;
+	opsStarted++;
 
-				//put the response at the back of the queue so when all the writes empty out, the response is ready to go
-				currentTransaction->transactionType = LOGIC_RESPONSE;
-				outgoingQueue.push_back(currentTransaction);
+	LogicTypeStats &stats = typeStats[context.logicOperation->logicType];
+	stats.started++;
+	stats.linkBytes += context.transaction->transactionSize;
 
-				break;
-			case LogicOperation::MEM_COPY:
-				//
-				//Arguments : 1) Destination Address
-				//            2) Size
-				//
-
-				uint64_t sourceAddress;
-				uint64_t destinationAddress; //start of destination copy
-				uint64_t sizeToCopy; //number of 64-byte words to copy
-				if(currentLogicOperation->arguments.size()!=2)
-				{
-					ERROR("== ERROR - Incorrect number of arguments for logic operation "<<currentLogicOperation->logicType);
-					exit(-1);
-				}
+	if(DEBUG_LOGIC) DEBUG(" == In logic layer "<<simpleControllerID<<" : interpreting transaction "<<*context.transaction<<" in context "<<c);
 
-				sourceAddress = currentTransaction->address;
-				destinationAddress = currentLogicOperation->arguments[0];
-				sizeToCopy = currentLogicOperation->arguments[1];
+	// grabbed the pointers, now we can remove from queue
+	pendingLogicOpsQueue.pop_front();
 
-				if(DEBUG_LOGIC)
-				{
-					DEBUG("       MEM COPY");
-					DEBUG("        Source Address      : 0x"<<hex<<setw(8)<<setfill('0')<<sourceAddress);
-					DEBUG("        Dest Address        : 0x"<<hex<<setw(8)<<setfill('0')<<destinationAddress);
-					DEBUG("        Size to copy (x64B) : "<<dec<<sizeToCopy);
-				}
+	//user-defined ops are up to their handler
+	LogicOperationHandler *handler = HandlerFor(context.logicOperation);
+	if(handler!=NULL)
+	{
+		ContextActions actions(this, c);
+		handler->Start(actions, context.logicOperation, context.transaction->address);
+		return;
+	}
 
-				for(int i=0; i<sizeToCopy; i++)
-				{
-					Transaction *trans = new Transaction(DATA_READ, 64, sourceAddress + i*(1<<(log2(BUS_ALIGNMENT_SIZE)+log2(NUM_CHANNELS))));
-					trans->originatedFromLogicOp = true;
+	//figure out what to do for each type
+	switch(context.logicOperation->logicType)
+	{
+	case LogicOperation::PAGE_FILL:
+		//
+		//Arguments:  1) Number of continuous pages
+		//            2) Pattern to copy
+		//
+		uint64_t pageStart;
+		uint64_t numPages;
+		uint pattern;
+		if(context.logicOperation->arguments.size()!=2)
+		{
+			ERROR("== ERROR - Incorrect number of arguments for logic operation "<<context.logicOperation->logicType);
+			exit(-1);
+		}
 
-					if(DEBUG_LOGIC) DEBUG("      == Logic Op created : "<<*trans);
+		//get arguments
+		pageStart = context.transaction->address;
+		numPages = context.logicOperation->arguments[0];
+		pattern = (uint)context.logicOperation->arguments[1];
 
-					outgoingQueue.push_back(trans);
-				}
+		if(DEBUG_LOGIC)
+		{
+			DEBUG("       PAGE FILL");
+			DEBUG("        Start     : "<<pageStart);
+			DEBUG("        Num Pages : "<<numPages);
+			DEBUG("        Fill with : "<<pattern);
+		}
 
-				break;
-			case LogicOperation::PAGE_TABLE_WALK:
-				uint64_t src_address;
-				src_address = currentTransaction->address;
-				for (size_t i=0; i<currentLogicOperation->arguments.size(); i++)
-				{
-					Transaction *trans = new Transaction(DATA_READ, 64, currentLogicOperation->arguments[i]);
-					trans->originatedFromLogicOp = true;
-					outgoingQueue.push_back(trans);
-				}
+		//the pattern is repeated across every word of the lines - which are this channel's lines
+		//  from pageStart on, one column apart
+		for(uint64_t i=0; i<numPages; i++)
+		{
+			FillLine(SimpleController::ChannelLine(pageStart, i), ((uint64_t)pattern<<32) | pattern);
+		}
 
-				break;
-			default:
-				ERROR("== ERROR - Unknown logic type in logic layer : "<<currentLogicOperation->logicType);
-				exit(-1);
-			}
+		//generate the writes required to write a pattern to each page
+		IssueLines(c);
+		break;
+	case LogicOperation::MEM_COPY:
+		//
+		//Arguments : 1) Destination Address
+		//            2) Size
+		//
+
+		uint64_t sourceAddress;
+		uint64_t destinationAddress; //start of destination copy
+		uint64_t sizeToCopy; //number of 64-byte words to copy
+		if(context.logicOperation->arguments.size()!=2)
+		{
+			ERROR("== ERROR - Incorrect number of arguments for logic operation "<<context.logicOperation->logicType);
+			exit(-1);
+		}
+
+		sourceAddress = context.transaction->address;
+		destinationAddress = context.logicOperation->arguments[0];
+		sizeToCopy = context.logicOperation->arguments[1];
+
+		if(DEBUG_LOGIC)
+		{
+			DEBUG("       MEM COPY");
+			DEBUG("        Source Address      : 0x"<<hex<<setw(8)<<setfill('0')<<sourceAddress);
+			DEBUG("        Dest Address        : 0x"<<hex<<setw(8)<<setfill('0')<<destinationAddress);
+			DEBUG("        Size to copy (x64B) : "<<dec<<sizeToCopy);
+		}
+
+		IssueLines(c);
+		break;
+	case LogicOperation::PAGE_TABLE_WALK:
+		IssueLines(c);
+		break;
+	case LogicOperation::REDUCE:
+		//
+		//Arguments : 1) Number of lines
+		//            2) Reduce function
+		//
+		uint64_t numLines;
+		if(context.logicOperation->arguments.size()!=2 || context.logicOperation->arguments[1]>LogicOperation::REDUCE_COUNT)
+		{
+			ERROR("== ERROR - Incorrect arguments for logic operation "<<context.logicOperation->logicType);
+			exit(-1);
+		}
+
+		numLines = context.logicOperation->arguments[0];
+		context.logicOperation->result = context.logicOperation->arguments[1]==LogicOperation::REDUCE_MIN ? UINT64_MAX : 0;
+
+		if(DEBUG_LOGIC)
+		{
+			DEBUG("       REDUCE");
+			DEBUG("        Start     : 0x"<<hex<<setw(8)<<setfill('0')<<context.transaction->address<<dec);
+			DEBUG("        Num Lines : "<<numLines);
+			DEBUG("        Function  : "<<context.logicOperation->arguments[1]);
+		}
 
+		//nothing to read - the result is ready now
+		if(numLines==0)
+		{
+			SendResponse(c);
+		}
+
+		IssueLines(c);
+		break;
+	case LogicOperation::GATHER:
+	case LogicOperation::SCATTER:
+		//
+		//Arguments : 1) Element size (bytes)
+		//            2...) Element indices from the start address
+		//
+		if(context.logicOperation->arguments.size()<1 || context.logicOperation->arguments[0]==0 ||
+		        context.logicOperation->arguments[0]>CACHE_LINE_SIZE)
+		{
+			ERROR("== ERROR - Incorrect arguments for logic operation "<<context.logicOperation->logicType);
+			exit(-1);
+		}
+
+		if(DEBUG_LOGIC)
+		{
+			DEBUG("       "<<(context.logicOperation->logicType==LogicOperation::GATHER ? "GATHER" : "SCATTER"));
+			DEBUG("        Base         : 0x"<<hex<<setw(8)<<setfill('0')<<context.transaction->address<<dec);
+			DEBUG("        Element size : "<<context.logicOperation->arguments[0]);
+			DEBUG("        Elements     : "<<context.logicOperation->arguments.size()-1);
+		}
+
+		//no elements - nothing to wait for
+		if(context.logicOperation->arguments.size()==1)
+		{
+			SendResponse(c);
 		}
 		else
 		{
-			ERROR(" == Error - Logic operation has no contents : "<<*newOperationQueue[0]);
+			IssueElements(c);
+		}
+		break;
+	case LogicOperation::ATOMIC_ADD:
+	case LogicOperation::ATOMIC_SWAP:
+	case LogicOperation::ATOMIC_CAS:
+		//
+		//Arguments : ADD) Value to add    SWAP) New value    CAS) 1) Expected value  2) New value
+		//
+		if(context.logicOperation->arguments.size()!=(context.logicOperation->logicType==LogicOperation::ATOMIC_CAS ? 2 : 1))
+		{
+			ERROR("== ERROR - Incorrect number of arguments for logic operation "<<context.logicOperation->logicType);
 			exit(-1);
 		}
-	}
 
+		if(DEBUG_LOGIC)
+		{
+			DEBUG("       ATOMIC "<<context.logicOperation->logicType);
+			DEBUG("        Address   : 0x"<<hex<<setw(8)<<setfill('0')<<context.transaction->address<<dec);
+		}
 
-	//if we're getting data, it is probably from a logic op that generated requests
-	if(!newOperationQueue.empty() && newOperationQueue[0]->transactionType == RETURN_DATA)
-	{
+		//otherwise Update() starts it once there is room for the read
+		if(CanSend(true))
+		{
+			StartAtomic(c);
+		}
+		break;
+	case LogicOperation::CHASE:
 		//
-		//do some checks to ensure the data makes sense
+		//Arguments : 1) Maximum number of hops
+		//            2) Offset of the next pointer in each node (bytes)
+		//            3...) Nodes after the first, each one only read once the one before it is back (optional - otherwise
+		//                  the next pointer comes from the backing store)
 		//
-		if(currentTransaction==NULL)
+		if(context.logicOperation->arguments.size()<2 || context.logicOperation->arguments[0]==0 ||
+		        context.logicOperation->arguments[1]+8>CACHE_LINE_SIZE)
 		{
-			ERROR("== ERROR - Getting data without a corresponding transaction");
+			ERROR("== ERROR - Incorrect arguments for logic operation "<<context.logicOperation->logicType);
 			exit(-1);
 		}
 
-		if (DEBUG_LOGIC) DEBUG("   ==[L:"<<simpleControllerID<<"] oh hai, return data"<<*newOperationQueue[0]);
-		//handle the return data based on the logic op that is being executed
+		if(DEBUG_LOGIC)
+		{
+			DEBUG("       CHASE");
+			DEBUG("        First node : 0x"<<hex<<setw(8)<<setfill('0')<<context.transaction->address<<dec);
+			DEBUG("        Max hops   : "<<context.logicOperation->arguments[0]);
+			DEBUG("        Node list  : "<<context.logicOperation->arguments.size()-2);
+		}
+
+		ChaseHop(c, context.transaction->address);
+		break;
+	default:
+		ERROR("== ERROR - Unknown logic type in logic layer : "<<context.logicOperation->logicType);
+		exit(-1);
+	}
+}
+
+//Hands data coming back from DRAM to the logic op that asked for it
+void LogicLayerInterface::ReturnData(Transaction *data)
+{
+	//
+	//do some checks to ensure the data makes sense
+	//
+	map<unsigned, unsigned>::iterator it = requestContexts.find(data->transactionID);
+
+	//data for another logic layer's read goes back to it over the side-band path
+	map<unsigned, unsigned>::iterator remote = remoteReads.find(data->transactionID);
+	if(it==requestContexts.end() && remote!=remoteReads.end())
+	{
+		if(DEBUG_LOGIC) DEBUG("   ==[L:"<<simpleControllerID<<"] sending data for channel "<<remote->second<<" back : "<<*data);
+		data->mappedChannel = remote->second;
+		remoteReads.erase(remote);
+		transferQueue.push_back(data);
+		return;
+	}
+
+	if(it==requestContexts.end())
+	{
+		ERROR("== ERROR - Getting data without a corresponding transaction : "<<*data);
+		exit(-1);
+	}
+	unsigned c = it->second;
+	requestContexts.erase(it);
+
+	LogicContext &context = contexts[c];
+	context.returnedRequests++;
+
+	if (DEBUG_LOGIC) DEBUG("   ==[L:"<<simpleControllerID<<"] oh hai, return data for context "<<c<<" "<<*data);
+
+	LogicOperationHandler *handler = HandlerFor(context.logicOperation);
+	if(handler!=NULL)
+	{
+		ContextActions actions(this, c);
+		handler->ReturnData(actions, context.logicOperation, data->address);
+		delete data;
+		return;
+	}
+
+	//handle the return data based on the logic op that is being executed
+	switch(context.logicOperation->logicType)
+	{
+	case LogicOperation::MEM_COPY:
 		Transaction *t;
-		switch(currentLogicOperation->logicType)
+		if (DEBUG_LOGIC) DEBUG(data->address - context.transaction->address);
+		t = new Transaction(DATA_WRITE, 64, data->address - context.transaction->address + context.logicOperation->arguments[0]);
+
+		if(DEBUG_LOGIC) DEBUG("      == Logic Op Copy moved data from 0x"<<hex<<setw(8)<<setfill('0')<<data->address<<dec<<" to : "<<*t);
+
+		//the write waits in the context if the queues are full
+		context.waitingWrites.push_back(t);
+		SendWaitingWrites(c);
+
+		//check to see if we are done with the requests
+		CheckWritesDone(c);
+		break;
+	case LogicOperation::PAGE_TABLE_WALK:
+		if (DEBUG_LOGIC) DEBUG("   ==[L:"<<simpleControllerID<<"] Getting back PT read for 0x"<<std::hex<<(data->address)<<std::dec<<"("<<context.returnedRequests<<"/"<<context.logicOperation->arguments.size()<<")");
+
+		//check to see if we are done with the requests
+		if(context.returnedRequests == context.logicOperation->arguments.size())
 		{
-		case LogicOperation::MEM_COPY:
-			if (DEBUG_LOGIC) DEBUG(newOperationQueue[0]->address - currentTransaction->address);
-			t = new Transaction(DATA_WRITE, 64, newOperationQueue[0]->address - currentTransaction->address + currentLogicOperation->arguments[0]);
-			t->originatedFromLogicOp = true;
+			if(DEBUG_LOGIC) DEBUG("      ==[L:"<<simpleControllerID<<"] All walked all page table levels, - creating response");
 
-			if(DEBUG_LOGIC) DEBUG("      == Logic Op Copy moved data from 0x"<<hex<<setw(8)<<setfill('0')<<newOperationQueue[0]->address<<dec<<" to : "<<*t);
+			//send back response
+			SendResponse(c);
+		}
+		break;
+	case LogicOperation::REDUCE:
+		ReduceLine(c, data->address);
 
-			outgoingQueue.push_back(t);
+		//the result goes back once the ALU is done with the last line
+		if(context.returnedRequests == context.logicOperation->arguments[0])
+		{
+			if(DEBUG_LOGIC) DEBUG("      ==[L:"<<simpleControllerID<<"] Reduced all lines - response on cycle "<<aluFreeCycle);
 
-			issuedRequests++;
+			context.responseCycle = aluFreeCycle;
+			reducesCompleted++;
+			linesReduced += context.logicOperation->arguments[0];
+		}
+		break;
+	case LogicOperation::ATOMIC_ADD:
+	case LogicOperation::ATOMIC_SWAP:
+	case LogicOperation::ATOMIC_CAS:
+		//modify, then write back and answer
+		aluFreeCycle = max(aluFreeCycle, currentClockCycle) + LOGIC_ATOMIC_LATENCY;
+		context.responseCycle = aluFreeCycle;
+		break;
+	case LogicOperation::CHASE:
+		chaseHops++;
+		hopLatencyTotal += currentClockCycle - context.hopCycle;
 
-			newOperationQueue.erase(newOperationQueue.begin());
+		//the next node is either the next one in the list or whatever the pointer in this one holds
+		uint64_t nextNode;
+		if(context.logicOperation->arguments.size()>2)
+		{
+			nextNode = 1+context.nextElement < context.logicOperation->arguments.size() ? context.logicOperation->arguments[1+context.nextElement] : 0;
+		}
+		else
+		{
+			nextNode = ReadWord(context.logicOperation->result + context.logicOperation->arguments[1]);
+		}
 
-			//check to see if we are done with the requests
-			if(issuedRequests==currentLogicOperation->arguments[1])
-			{
-				if(DEBUG_LOGIC) DEBUG("      == All WRITE commands issued for copy - creating response");
+		//a null pointer or running out of hops ends the chain - the last node reached goes back
+		if(nextNode==0 || context.nextElement==context.logicOperation->arguments[0])
+		{
+			if(DEBUG_LOGIC) DEBUG("      ==[L:"<<simpleControllerID<<"] Chase done after "<<context.nextElement<<" hops - creating response");
+			chasesCompleted++;
+			SendResponse(c);
+		}
+		else
+		{
+			ChaseHop(c, nextNode);
+		}
+		break;
+	case LogicOperation::GATHER:
+		//the elements go back packed in the response
+		if(context.returnedRequests == context.logicOperation->arguments.size()-1)
+		{
+			if(DEBUG_LOGIC) DEBUG("      ==[L:"<<simpleControllerID<<"] Gathered all elements - creating response");
+			SendResponse(c);
+		}
+		break;
 
-				//send back response
-				currentTransaction->transactionType = LOGIC_RESPONSE;
-				outgoingQueue.push_back(currentTransaction);
-				issuedRequests = 0;
-			}
+	default:
+		ERROR("== ERROR - Getting data back for a logic op that doesnt create requests : "<<*context.transaction);
+		exit(-1);
+		break;
+	};
+
+	delete data;
+}
+
+//Sends a request generated by the logic op in context c to the channel
+void LogicLayerInterface::SendRequest(unsigned c, Transaction *trans)
+{
+	trans->originatedFromLogicOp = true;
+	contexts[c].issuedRequests++;
+
+	//data for reads comes back tagged with the read's ID
+	if(trans->transactionType==DATA_READ)
+	{
+		requestContexts[trans->transactionID] = c;
+	}
+
+	if(DEBUG_LOGIC) DEBUG("      == Logic Op created : "<<*trans);
+
+	CountRequest(c, trans);
+	outgoingQueue.push_back(trans);
+}
+
+//Sends a write generated by the logic op in context c - writes to data in another channel go
+//  over the side-band path
+void LogicLayerInterface::SendWrite(unsigned c, Transaction *trans)
+{
+	if(FindChannel==NULL || (*FindChannel)(trans->address,0)==simpleControllerID)
+	{
+		SendRequest(c, trans);
+		return;
+	}
+
+	trans->originatedFromLogicOp = true;
+	contexts[c].issuedRequests++;
+	contexts[c].pendingTransfers++;
+	transferContexts[trans->transactionID] = c;
+
+	if(DEBUG_LOGIC) DEBUG("      == Logic Op sending to another channel : "<<*trans);
+
+	CountRequest(c, trans);
+	transferQueue.push_back(trans);
+}
+
+//Keeps track of the DRAM traffic the op in context c generates
+void LogicLayerInterface::CountRequest(unsigned c, Transaction *trans)
+{
+	LogicTypeStats &stats = typeStats[contexts[c].logicOperation->logicType];
+	if(trans->transactionType==DATA_READ)
+	{
+		stats.reads++;
+		stats.readBytes += trans->transactionSize;
+	}
+	else
+	{
+		//a row burst fill covers several of this channel's lines
+		unsigned lines = max(1u, trans->transactionSize / TRANSACTION_SIZE);
+		stats.writes += lines;
+		stats.writeBytes += trans->transactionSize;
+
+		for(unsigned i=0; ReportWrite!=NULL && i<lines; i++)
+		{
+			(*ReportWrite)(SimpleController::ChannelLine(trans->address, i), 0);
+		}
+	}
+}
+
+//Data sent to another channel has been taken by that channel
+void LogicLayerInterface::TransferComplete(unsigned transactionID)
+{
+	map<unsigned, unsigned>::iterator it = transferContexts.find(transactionID);
+	if(it==transferContexts.end())
+	{
+		ERROR("== ERROR - Transfer T"<<transactionID<<" completed without a corresponding transaction");
+		exit(-1);
+	}
+	unsigned c = it->second;
+	transferContexts.erase(it);
+
+	contexts[c].pendingTransfers--;
+	CheckWritesDone(c);
+}
+
+//A copy (or scatter) is done once all of its writes are out and the ones for other channels have been taken there
+void LogicLayerInterface::CheckWritesDone(unsigned c)
+{
+	LogicContext &context = contexts[c];
+	bool allWritten = context.logicOperation->logicType==LogicOperation::SCATTER ?
+	                  context.nextElement==context.logicOperation->arguments.size()-1 :
+	                  context.returnedRequests==context.logicOperation->arguments[1] && context.waitingWrites.empty();
+	if(allWritten && context.pendingTransfers==0)
+	{
+		if(DEBUG_LOGIC) DEBUG("      == All WRITE commands issued for copy - creating response");
+
+		//send back response
+		SendResponse(c);
+	}
+}
+
+//Sends out the next elements of the GATHER or SCATTER in context c - a gather keeps up to
+//  LOGIC_GATHER_PARALLELISM reads in flight and a scatter sends that many writes each cycle
+void LogicLayerInterface::IssueElements(unsigned c)
+{
+	LogicContext &context = contexts[c];
+	LogicOperation *op = context.logicOperation;
+	bool gather = op->logicType==LogicOperation::GATHER;
+	uint64_t numElements = op->arguments.size()-1;
+
+	for(unsigned issued=0; issued<LOGIC_GATHER_PARALLELISM && context.nextElement<numElements; issued++)
+	{
+		if((gather && context.issuedRequests - context.returnedRequests >= LOGIC_GATHER_PARALLELISM) || !CanSend(gather))
+		{
 			break;
-		case LogicOperation::PAGE_TABLE_WALK:
-			issuedRequests++;
+		}
 
-			if (DEBUG_LOGIC) DEBUG("   ==[L:"<<simpleControllerID<<"] Getting back PT read for 0x"<<std::hex<<(newOperationQueue[0]->address)<<std::dec<<"("<<issuedRequests<<"/3)");
+		//the whole line holding the element is accessed
+		uint64_t address = (context.transaction->address + op->arguments[1+context.nextElement]*op->arguments[0]) & ~(uint64_t)(CACHE_LINE_SIZE-1);
+		context.nextElement++;
 
-			//check to see if we are done with the requests
-			if(issuedRequests == currentLogicOperation->arguments.size())
-			{
-				if(DEBUG_LOGIC) DEBUG("      ==[L:"<<simpleControllerID<<"] All walked all page table levels, - creating response");
+		if(gather)
+		{
+			SendRead(c, new Transaction(DATA_READ, 64, address));
+		}
+		else
+		{
+			SendWrite(c, new Transaction(DATA_WRITE, 64, address));
+		}
+	}
+
+	if(!gather && context.nextElement==numElements)
+	{
+		CheckWritesDone(c);
+	}
+}
+
+//Moves the chase in context c on to node - it waits for the line holding node's next pointer
+//  before going on (the read goes out from Update() if there's no room for it now)
+void LogicLayerInterface::ChaseHop(unsigned c, uint64_t node)
+{
+	LogicContext &context = contexts[c];
+	context.logicOperation->result = node;
+	context.nextElement++;
+
+	if(DEBUG_LOGIC) DEBUG("      ==[L:"<<simpleControllerID<<"] Chase hop "<<context.nextElement<<" to node 0x"<<hex<<node<<dec);
+
+	if(CanSend(true))
+	{
+		SendChaseRead(c);
+	}
+}
+
+//Reads the line holding the next pointer of the node the chase in context c is on
+void LogicLayerInterface::SendChaseRead(unsigned c)
+{
+	LogicContext &context = contexts[c];
+	context.hopCycle = currentClockCycle;
+	SendRead(c, new Transaction(DATA_READ, 64, (context.logicOperation->result + context.logicOperation->arguments[1]) & ~(uint64_t)(CACHE_LINE_SIZE-1)));
+}
+
+//Sends the copy writes waiting in context c that the queues have room for
+void LogicLayerInterface::SendWaitingWrites(unsigned c)
+{
+	vector<Transaction *> &waiting = contexts[c].waitingWrites;
+	while(waiting.size()>0 && CanSend(false))
+	{
+		SendWrite(c, waiting[0]);
+		waiting.erase(waiting.begin());
+	}
+}
+
+//Sends a read generated by the op in context c - lines in another channel are read there, with
+//  the request and its data going over the side-band path
+void LogicLayerInterface::SendRead(unsigned c, Transaction *trans)
+{
+	if(FindChannel==NULL || (*FindChannel)(trans->address,0)==simpleControllerID)
+	{
+		SendRequest(c, trans);
+		return;
+	}
+
+	trans->originatedFromLogicOp = true;
+	contexts[c].issuedRequests++;
+	requestContexts[trans->transactionID] = c;
+	remoteReadsSent++;
+
+	if(DEBUG_LOGIC) DEBUG("      == Logic Op reading from another channel : "<<*trans);
+
+	CountRequest(c, trans);
+	transferQueue.push_back(trans);
+}
+
+//Number of lines a PAGE_FILL, MEM_COPY, REDUCE or PAGE_TABLE_WALK requests (0 for other ops)
+uint64_t LogicLayerInterface::LinesToIssue(LogicContext &context)
+{
+	vector<uint64_t> &arguments = context.logicOperation->arguments;
+	switch(context.logicOperation->logicType)
+	{
+	case LogicOperation::PAGE_FILL:
+		//a row burst fill is one write covering every line
+		return PAGE_FILL_ROW_BURSTS && arguments[0]>1 ? 1 : arguments[0];
+	case LogicOperation::MEM_COPY:
+		return arguments[1];
+	case LogicOperation::REDUCE:
+		return arguments[0];
+	case LogicOperation::PAGE_TABLE_WALK:
+		return arguments.size();
+	default:
+		return 0;
+	}
+}
+
+//Sends out the next lines of the op in context c, as many as the queues have room for
+void LogicLayerInterface::IssueLines(unsigned c)
+{
+	LogicContext &context = contexts[c];
+	LogicOperation *op = context.logicOperation;
+	bool fill = op->logicType==LogicOperation::PAGE_FILL;
+	uint64_t numLines = LinesToIssue(context);
 
-				//send back response
-				currentTransaction->transactionType = LOGIC_RESPONSE;
-				outgoingQueue.push_back(currentTransaction);
-				issuedRequests = 0;
+	while(context.nextElement<numLines && CanSend(!fill))
+	{
+		uint64_t i = context.nextElement++;
+		if(op->logicType==LogicOperation::PAGE_TABLE_WALK)
+		{
+			SendRead(c, new Transaction(DATA_READ, 64, op->arguments[i]));
+		}
+		else if(fill && PAGE_FILL_ROW_BURSTS && op->arguments[0]>1)
+		{
+			//one write covering every line lets the simple controller open each row once
+			SendRequest(c, new Transaction(DATA_WRITE, op->arguments[0]*TRANSACTION_SIZE, context.transaction->address));
+		}
+		else
+		{
+			//fills, copies and reduces work on this channel's lines
+			uint64_t address = SimpleController::ChannelLine(context.transaction->address, i);
+			if(fill)
+			{
+				SendRequest(c, new Transaction(DATA_WRITE, 64, address));
+			}
+			else
+			{
+				SendRead(c, new Transaction(DATA_READ, 64, address));
 			}
-			newOperationQueue.erase(newOperationQueue.begin());
+		}
+	}
 
-			break;
+	//put the response at the back of the queue so when all the writes empty out, the response is ready to go
+	if(fill && context.nextElement==numLines)
+	{
+		SendResponse(c);
+	}
+}
 
-		default:
-			ERROR("== ERROR - Getting data back for a logic op that doesnt create requests : "<<*currentTransaction);
-			exit(-1);
+//Whether the logic layer can send another request - requests for this channel and for others
+//  share LOGIC_OUTGOING_QUEUE_DEPTH with a spot kept for each op's response, and reads also
+//  need a spot for their data
+bool LogicLayerInterface::CanSend(bool read)
+{
+	unsigned queued = outgoingQueue.size();
+	for(unsigned i=0; i<transferQueue.size(); i++)
+	{
+		//data going back for another channel's read is bounded by that channel's reads out
+		if(transferQueue[i]->transactionType!=RETURN_DATA) queued++;
+	}
+	for(unsigned c=0; c<contexts.size(); c++)
+	{
+		if(contexts[c].transaction!=NULL && contexts[c].transaction->transactionType!=LOGIC_RESPONSE) queued++;
+	}
+
+	return queued<LOGIC_OUTGOING_QUEUE_DEPTH && (!read || requestContexts.size()<LOGIC_RETURN_QUEUE_DEPTH);
+}
+
+void LogicLayerInterface::ResetQueueStats()
+{
+	pendingOpsOccupancy = 0;
+	outgoingOccupancy = 0;
+	readsOutOccupancy = 0;
+	pendingOpsMax = 0;
+	outgoingMax = 0;
+	readsOutMax = 0;
+	statCycles = 0;
+}
+
+//Value of the 8-byte word holding address in the functional backing store
+uint64_t LogicLayerInterface::ReadWord(uint64_t address)
+{
+	//e.g., a chase's next pointer in a node another channel just read for it
+	LogicLayerInterface *owner = FindLayer!=NULL ? (*FindLayer)(address,0) : this;
+	if(owner!=this)
+	{
+		return owner->ReadWord(address);
+	}
+
+	map<uint64_t, uint64_t>::iterator it = wordValues.find(address & ~(uint64_t)7);
+	if(it!=wordValues.end())
+	{
+		return it->second;
+	}
+
+	it = linePatterns.find(address / CACHE_LINE_SIZE);
+	return it!=linePatterns.end() ? it->second : 0;
+}
+
+void LogicLayerInterface::WriteWord(uint64_t address, uint64_t value)
+{
+	LogicLayerInterface *owner = FindLayer!=NULL ? (*FindLayer)(address,0) : this;
+	if(owner!=this)
+	{
+		owner->WriteWord(address, value);
+		return;
+	}
+
+	wordValues[address & ~(uint64_t)7] = value;
+}
+
+//Sets every word of the line holding address to pattern
+void LogicLayerInterface::FillLine(uint64_t address, uint64_t pattern)
+{
+	uint64_t lineStart = address & ~(uint64_t)(CACHE_LINE_SIZE-1);
+	wordValues.erase(wordValues.lower_bound(lineStart), wordValues.lower_bound(lineStart + CACHE_LINE_SIZE));
+	linePatterns[lineStart / CACHE_LINE_SIZE] = pattern;
+}
+
+bool LogicLayerInterface::IsAtomic(LogicOperation *op)
+{
+	return op->logicType==LogicOperation::ATOMIC_ADD ||
+	       op->logicType==LogicOperation::ATOMIC_CAS ||
+	       op->logicType==LogicOperation::ATOMIC_SWAP;
+}
+
+//Reads the line for the atomic in context c if no other atomic holds its lock - returns false if it has to wait
+bool LogicLayerInterface::StartAtomic(unsigned c)
+{
+	LogicContext &context = contexts[c];
+	unsigned entry = (context.transaction->address / CACHE_LINE_SIZE) % lockTable.size();
+	if(lockTable[entry])
+	{
+		if(DEBUG_LOGIC) DEBUG("      ==[L:"<<simpleControllerID<<"] Atomic in context "<<c<<" waiting on lock "<<entry);
+		return false;
+	}
+
+	lockTable[entry] = true;
+	context.lockEntry = entry;
+	SendRequest(c, new Transaction(DATA_READ, 64, context.transaction->address & ~(uint64_t)(CACHE_LINE_SIZE-1)));
+	return true;
+}
+
+//Does the modify step of the atomic in context c, writes the line back if it changed and
+//  sends back the old value
+void LogicLayerInterface::CompleteAtomic(unsigned c)
+{
+	LogicContext &context = contexts[c];
+	LogicOperation *op = context.logicOperation;
+	uint64_t word = context.transaction->address & ~(uint64_t)7;
+
+	uint64_t oldValue = ReadWord(word);
+	uint64_t newValue = oldValue;
+	switch(op->logicType)
+	{
+	case LogicOperation::ATOMIC_ADD:
+		newValue = oldValue + op->arguments[0];
+		break;
+	case LogicOperation::ATOMIC_SWAP:
+		newValue = op->arguments[0];
+		break;
+	case LogicOperation::ATOMIC_CAS:
+		if(oldValue==op->arguments[0])
+		{
+			newValue = op->arguments[1];
+		}
+		break;
+	default:
+		break;
+	}
+	op->result = oldValue;
+
+	//a failed compare leaves memory alone
+	if(newValue!=oldValue || op->logicType==LogicOperation::ATOMIC_SWAP)
+	{
+		WriteWord(word, newValue);
+		SendRequest(c, new Transaction(DATA_WRITE, 64, context.transaction->address & ~(uint64_t)(CACHE_LINE_SIZE-1)));
+	}
+
+	if(DEBUG_LOGIC) DEBUG("      ==[L:"<<simpleControllerID<<"] Atomic on 0x"<<hex<<word<<dec<<" : "<<oldValue<<" -> "<<newValue);
+
+	//the write is queued ahead of anything a later atomic to this line will send, and the simple
+	//  controller never puts a logic request ahead of one for the same line
+	lockTable[context.lockEntry] = false;
+	context.lockEntry = -1;
+
+	atomicsCompleted++;
+	atomicLatencyTotal += currentClockCycle - context.startCycle;
+	SendResponse(c);
+}
+
+//Folds a line that came back into the result of the REDUCE in context c
+void LogicLayerInterface::ReduceLine(unsigned c, uint64_t address)
+{
+	//the ALU takes one line at a time
+	aluFreeCycle = max(aluFreeCycle, currentClockCycle) + LOGIC_REDUCE_ALU_LATENCY;
+
+	LogicOperation *op = contexts[c].logicOperation;
+	for(unsigned w=0; w<CACHE_LINE_SIZE/8; w++)
+	{
+		uint64_t word = ReadWord(address + w*8);
+		switch(op->arguments[1])
+		{
+		case LogicOperation::REDUCE_SUM:
+			op->result += word;
+			break;
+		case LogicOperation::REDUCE_MIN:
+			op->result = min(op->result, word);
 			break;
-		};
+		case LogicOperation::REDUCE_MAX:
+			op->result = max(op->result, word);
+			break;
+		case LogicOperation::REDUCE_COUNT:
+			if(word!=0) op->result++;
+			break;
+		}
 	}
-	currentClockCycle++;
+}
+
+//Queues the response for the logic op in context c - the context is freed once it has been taken
+void LogicLayerInterface::SendResponse(unsigned c)
+{
+	contexts[c].transaction->transactionType = LOGIC_RESPONSE;
+	outgoingQueue.push_back(contexts[c].transaction);
+
+	typeStats[contexts[c].logicOperation->logicType].linkBytes += LOGIC_RESPONSE_PACKET_OVERHEAD + contexts[c].logicOperation->resultSize;
 }
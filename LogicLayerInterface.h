@@ -36,10 +36,39 @@ using namespace std;
 #include "Transaction.h"
 #include "DRAMChannel.h"
 #include "LogicOperation.h"
+#include "LogicOperationHandler.h"
 #include <deque>
+#include <map>
 
 namespace BOBSim
 {
+//A logic operation the logic layer is working on
+struct LogicContext
+{
+	Transaction *transaction; //the LOGIC_OPERATION transaction - NULL if the context is free
+	LogicOperation *logicOperation; //holds on to the logic operation object
+	uint issuedRequests; //requests sent out for this op
+	uint returnedRequests; //data returned for this op
+	uint pendingTransfers; //data sent to another channel which hasn't been taken there yet
+	uint nextElement; //next element (or line) the op will request
+	int lockEntry; //lock table entry an atomic holds (-1 if none)
+	uint64_t startCycle;
+	uint64_t responseCycle; //cycle a computed result is ready to be sent back (0 if none is being computed)
+	uint64_t hopCycle; //cycle the current CHASE hop was sent out
+	vector<Transaction *> waitingWrites; //MEM_COPY writes waiting for room in the queues
+};
+
+//What the ops of one logic type did (reset each epoch)
+struct LogicTypeStats
+{
+	unsigned started;
+	uint64_t reads; //DRAM requests the ops generated
+	uint64_t writes;
+	uint64_t readBytes;
+	uint64_t writeBytes;
+	uint64_t linkBytes; //bytes the ops' request and response packets took on the link buses
+};
+
 class LogicLayerInterface
 {
 public:
@@ -47,20 +76,90 @@ public:
 
 	void ReceiveLogicOperation(Transaction *trans, unsigned i);
 	void RegisterReturnCallback(Callback<DRAMChannel, bool, Transaction*, unsigned> *returnCallback);
+	void RegisterChannelCallback(Callback<BOB, unsigned, uint64_t, unsigned> *channelCallback);
+	void RegisterWriteCallback(Callback<BOB, void, uint64_t, unsigned> *writeCallback);
+	void RegisterLayerCallback(Callback<BOB, LogicLayerInterface*, uint64_t, unsigned> *layerCallback);
 	void Update();
+	void StartLogicOperation(unsigned c);
+	void ReturnData(Transaction *data);
+	void SendRequest(unsigned c, Transaction *trans);
+	void SendResponse(unsigned c);
+	void SendWrite(unsigned c, Transaction *trans);
+	void SendRead(unsigned c, Transaction *trans);
+	void SendWaitingWrites(unsigned c);
+	void SendChaseRead(unsigned c);
+	void CountRequest(unsigned c, Transaction *trans);
+	void TransferComplete(unsigned transactionID);
+	void CheckWritesDone(unsigned c);
+	void IssueElements(unsigned c);
+	uint64_t LinesToIssue(LogicContext &context);
+	void IssueLines(unsigned c);
+	bool CanSend(bool read);
+	void ResetQueueStats();
+	uint64_t ReadWord(uint64_t address);
+	void WriteWord(uint64_t address, uint64_t value);
+	void FillLine(uint64_t address, uint64_t pattern);
+	bool IsAtomic(LogicOperation *op);
+	bool StartAtomic(unsigned c);
+	void CompleteAtomic(unsigned c);
+	void ReduceLine(unsigned c, uint64_t address);
+	void ChaseHop(unsigned c, uint64_t node);
+	void RespondAfterALU(unsigned c, unsigned aluCycles);
+	LogicOperationHandler *HandlerFor(LogicOperation *op);
+
+	//Handlers for user-defined logic operation types, shared by every logic layer
+	static map<unsigned, LogicOperationHandler *> handlers;
+	static void RegisterHandler(unsigned logicType, LogicOperationHandler *handler);
 
 	Callback<DRAMChannel, bool, Transaction*, unsigned> *ReturnToSimpleController;
+	Callback<BOB, unsigned, uint64_t, unsigned> *FindChannel;
+	Callback<BOB, void, uint64_t, unsigned> *ReportWrite; //told about every line a logic op writes
+	Callback<BOB, LogicLayerInterface*, uint64_t, unsigned> *FindLayer; //logic layer of the channel an address lives in
 
 	uint simpleControllerID;
 	uint64_t currentClockCycle;
-	Transaction *currentTransaction; //the current operation the logic layer is working on
-	LogicOperation *currentLogicOperation; //holds on to current logic operation object
+	vector<LogicContext> contexts; //the operations the logic layer is working on (LOGIC_OPERATION_CONTEXTS)
+	unsigned activeContexts;
+	map<unsigned, unsigned> requestContexts; //transaction ID of a read sent out -> context waiting on its data
 	deque<Transaction *> pendingLogicOpsQueue;
 	vector<Transaction *> newOperationQueue; //incoming LOGIC_OPERATION transactions
 	vector<Transaction *> outgoingQueue; //requests or responses generated from LOGIC_OPERATION transaction
+	deque<Transaction *> transferQueue; //writes for other channels, waiting for the side-band path in BOB
+	map<unsigned, unsigned> transferContexts; //transaction ID of data sent to another channel -> context
+	map<unsigned, unsigned> remoteReads; //transaction ID of a read from another logic layer -> its channel
+
+	//Cycle the ALU can start on the next line
+	uint64_t aluFreeCycle;
+	//Lines locked by atomics in progress, indexed by line % LOGIC_ATOMIC_LOCK_ENTRIES
+	vector<bool> lockTable;
+	//Functional backing store - the value of each word written by an atomic and the pattern
+	//  of each line written by a fill (everything else reads as zero).  Words of lines in
+	//  other channels are kept by those channels' logic layers
+	map<uint64_t, uint64_t> wordValues;
+	map<uint64_t, uint64_t> linePatterns;
 
-	//keeps track of how many requests have been issued from this logic op
-	uint issuedRequests;
+	//Bookkeeping for stats (reset each epoch)
+	unsigned opsStarted;
+	unsigned opsCompleted;
+	uint64_t opLatencyTotal; //cycles from starting an op to its response being taken
+	uint64_t activeContextCycles; //sum of busy contexts over every cycle
+	uint64_t statCycles;
+	unsigned reducesCompleted;
+	uint64_t linesReduced;
+	unsigned atomicsCompleted;
+	uint64_t atomicLatencyTotal;
+	uint64_t lockWaitCycles; //cycles atomics spent waiting on a held lock
+	unsigned chasesCompleted;
+	unsigned remoteReadsSent; //reads sent to another channel over the side-band path
+	uint64_t chaseHops;
+	uint64_t hopLatencyTotal; //cycles from sending each hop's read to its data coming back
+	map<unsigned, LogicTypeStats> typeStats; //by logic type
+	uint64_t pendingOpsOccupancy; //sum of each queue's size over every cycle
+	uint64_t outgoingOccupancy;
+	uint64_t readsOutOccupancy;
+	unsigned pendingOpsMax;
+	unsigned outgoingMax;
+	unsigned readsOutMax;
 };
 }
 
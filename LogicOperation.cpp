@@ -30,8 +30,36 @@
 
 #include "LogicOperation.h"
 
-LogicOperation::LogicOperation(LogicType type, vector<uint64_t> &args)
+//Name of a built-in logic type for stats (user-defined types are all "USER")
+const char *LogicOperation::TypeName(unsigned logicType)
+{
+	const char *names[] = {"PAGE_FILL", "MEM_COPY", "PAGE_TABLE_WALK", "REDUCE", "GATHER", "SCATTER",
+	                       "ATOMIC_ADD", "ATOMIC_CAS", "ATOMIC_SWAP", "CHASE"
+	                      };
+	return logicType<=CHASE ? names[logicType] : "USER";
+}
+
+LogicOperation::LogicOperation(unsigned type, vector<uint64_t> &args)
 {
 	logicType = type;
 	arguments = args;
+	result = 0;
+	//reductions send back their result and atomics the old value
+	resultSize = (type==REDUCE || type==ATOMIC_ADD || type==ATOMIC_CAS || type==ATOMIC_SWAP || type==CHASE) ? 8 : 0;
+	requestPayload = 0;
+
+	//gather and scatter carry their index list (and scatter its data) and gather returns its elements packed
+	if((type==GATHER || type==SCATTER) && args.size()>0)
+	{
+		uint64_t numElements = args.size()-1;
+		if(type==GATHER)
+		{
+			requestPayload = numElements*8;
+			resultSize = numElements*args[0];
+		}
+		else
+		{
+			requestPayload = numElements*(8+args[0]);
+		}
+	}
 }
@@ -44,15 +44,40 @@ public:
 	{
 		PAGE_FILL,
 		MEM_COPY,
-		PAGE_TABLE_WALK
+		PAGE_TABLE_WALK,
+		REDUCE,
+		GATHER,
+		SCATTER,
+		ATOMIC_ADD,
+		ATOMIC_CAS,
+		ATOMIC_SWAP,
+		CHASE,
+		//types from here on are carried out by handlers registered with the logic layer
+		FIRST_USER_LOGIC_TYPE = 32
+	};
+
+	//What a REDUCE does with each 8-byte word in its range
+	enum ReduceFunction
+	{
+		REDUCE_SUM,
+		REDUCE_MIN,
+		REDUCE_MAX,
+		REDUCE_COUNT //words that aren't zero
 	};
 
 	//functions
-	LogicOperation(LogicType type, vector<uint64_t> &args);
+	LogicOperation(unsigned type, vector<uint64_t> &args);
+	static const char *TypeName(unsigned logicType);
 
 	//fields
-	LogicType logicType;
+	//one of LogicType, or a user-defined type from FIRST_USER_LOGIC_TYPE up
+	unsigned logicType;
 	vector<uint64_t> arguments;
+	//Value sent back with the response and its size in bytes (0 if the op only acknowledges)
+	uint64_t result;
+	unsigned resultSize;
+	//Bytes the op carries to memory besides its header (0 if it fits in a regular request)
+	unsigned requestPayload;
 };
 
 #endif
@@ -0,0 +1,77 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef LOGICOPERATIONHANDLER_H
+#define LOGICOPERATIONHANDLER_H
+
+#include <stdint.h>
+
+class LogicOperation;
+
+namespace BOBSim
+{
+//What a handler can do for the logic op it is working on in a logic layer
+class LogicOperationActions
+{
+public:
+	virtual ~LogicOperationActions() {}
+	//Whether the logic layer's queues have room for another request (reads also need a
+	//  spot for their data)
+	virtual bool CanSend(bool read) = 0;
+	//Reads (or writes) the line holding address, in whichever channel it belongs to - read data
+	//  comes back through ReturnData
+	virtual void Read(uint64_t address) = 0;
+	virtual void Write(uint64_t address) = 0;
+	//Finishes the op - its response goes back once the logic layer's ALU has spent aluCycles
+	//  (DRAM clock) on it
+	virtual void Respond(unsigned aluCycles) = 0;
+	//Words in the logic layer's functional backing store (anything never written reads as zero)
+	virtual uint64_t ReadWord(uint64_t address) = 0;
+	virtual void WriteWord(uint64_t address, uint64_t value) = 0;
+};
+
+//Carries out a user-defined logic operation type in the logic layers - one handler object is
+//  shared by every op of its type in every channel, so any per-op state belongs in the op
+//  (its arguments and result, see getLogicOpArguments() and setLogicOpResult() in BOBSim.h)
+class LogicOperationHandler
+{
+public:
+	virtual ~LogicOperationHandler() {}
+	//The op got a context in a logic layer - address is where the op was sent
+	virtual void Start(LogicOperationActions &logic, LogicOperation *op, uint64_t address) = 0;
+	//Data for one of the op's reads came back
+	virtual void ReturnData(LogicOperationActions &logic, LogicOperation *op, uint64_t address) = 0;
+	//Called every cycle (DRAM clock) until the op responds, e.g., to keep sending requests
+	//  the queues didn't have room for
+	virtual void Update(LogicOperationActions &, LogicOperation *) {}
+};
+}
+
+#endif
@@ -38,13 +38,18 @@ namespace BOBSim
 Port::Port():
 	portID(0),
 	inputBusyCountdown(0),
-	outputBusyCountdown(0)
+	outputBusyCountdown(0),
+	inputBufferCount(0),
+	responsesPending(0)
 {}
 
-Port::Port(unsigned id):
+Port::Port(unsigned id, unsigned numLinkBuses):
 	portID(id),
 	inputBusyCountdown(0),
-	outputBusyCountdown(0)
+	outputBusyCountdown(0),
+	inputQueues(numLinkBuses),
+	inputBufferCount(0),
+	responsesPending(0)
 {}
 
 } // namespace BOBSim
@@ -32,9 +32,11 @@
 #define PORT_H
 
 #include <vector>
+#include <deque>
 #include "Transaction.h"
 
 using std::vector;
+using std::deque;
 namespace BOBSim
 {
 class Port
@@ -42,7 +44,7 @@ class Port
 public:
 	//Functions
 	Port();
-	Port(unsigned id);
+	Port(unsigned id, unsigned numLinkBuses);
 
 	//Fields
 	//The port identifier in relation to the entire system
@@ -53,8 +55,13 @@ public:
 	//Amount of time that the port's output is busy
 	unsigned outputBusyCountdown;
 
-	//Input and output storage for transactions 
-	vector<Transaction *> inputBuffer;
+	//Input storage for transactions, sorted by the link bus they are headed to
+	vector< deque<Transaction *> > inputQueues;
+	//Total number of transactions in all input queues
+	unsigned inputBufferCount;
+	//Reads and logic operations sent from this port which have not been answered yet
+	unsigned responsesPending;
+	//Output storage for transactions
 	vector<Transaction *> outputBuffer;
 };
 }
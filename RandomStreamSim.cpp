@@ -76,9 +76,15 @@ vector<unsigned> randomSeeds;
 vector<unsigned> waitCounters;
 vector<unsigned> useCounters;
 
+//When set, requests are spread over the ports with the port heuristic instead of
+//  each stream always using its own port
+bool usePortHeuristic = false;
+
 void usage()
 {
-	cout << "Blah" << endl;
+	cout << "./BOBSim -c cycles [-n ports] [-H heuristic] [-T topology] [-q]" << endl;
+	cout << "  heuristics : first, rr, core, least, hash, jsq" << endl;
+	cout << "  topology   : channels per link bus, e.g. \"0,1>2,3@24;4,5;6;7\" (see LINK_TOPOLOGY in Globals.h)" << endl;
 }
 
 vector< vector<Transaction *> > transactionBuffer;
@@ -128,12 +134,14 @@ int main(int argc, char **argv)
 		{
 			{"pwd", required_argument, 0, 'p'},
 			{"numcycles",  required_argument,	0, 'c'},
+			{"heuristic",  required_argument,	0, 'H'},
+			{"topology",  required_argument,	0, 'T'},
 			{"quiet",  no_argument, &BOBSim::SHOW_SIM_OUTPUT, 'q'},
 			{"help", no_argument, 0, 'h'},
 			{0, 0, 0, 0}
 		};
 		int option_index=0; //for getopt
-		c = getopt_long (argc, argv, "c:n:p:bkq", long_options, &option_index);
+		c = getopt_long (argc, argv, "c:n:p:H:T:bkq", long_options, &option_index);
 		if (c == -1)
 		{
 			break;
@@ -163,6 +171,27 @@ int main(int argc, char **argv)
 			break;
 		case 'n':
 			BOBSim::NUM_PORTS = atoi(optarg);
+			break;
+		case 'H':
+		{
+			string heuristic(optarg);
+			usePortHeuristic = true;
+			if(heuristic=="first") BOBSim::portHeuristic = FIRST_AVAILABLE;
+			else if(heuristic=="rr") BOBSim::portHeuristic = ROUND_ROBIN;
+			else if(heuristic=="core") BOBSim::portHeuristic = PER_CORE;
+			else if(heuristic=="least") BOBSim::portHeuristic = LEAST_OCCUPIED;
+			else if(heuristic=="hash") BOBSim::portHeuristic = ADDRESS_HASHED;
+			else if(heuristic=="jsq") BOBSim::portHeuristic = JOIN_SHORTEST_QUEUE;
+			else
+			{
+				usage();
+				exit(0);
+			}
+			break;
+		}
+		case 'T':
+			BOBSim::LINK_TOPOLOGY = string(optarg);
+			break;
 		case 'p':
 			pwdString = string(optarg);
 			break;
@@ -204,7 +233,15 @@ int main(int argc, char **argv)
 			{
 				if(DEBUG_PORTS) DEBUG("== TraceBasedSim trying to send : port "<<l<<" : "<<*transactionBuffer[l][0]);
 
-				if(bobWrapper.AddTransaction(transactionBuffer[l][0],l))
+				//stream l acts as core l when the heuristic picks the port
+				int port = l;
+				if(usePortHeuristic)
+				{
+					transactionBuffer[l][0]->coreID = l;
+					port = bobWrapper.FindOpenPort(l, transactionBuffer[l][0]->address);
+				}
+
+				if(port>-1 && bobWrapper.AddTransaction(transactionBuffer[l][0],port))
 				{
 					transactionBuffer[l].erase(transactionBuffer[l].begin());
 				}
@@ -154,7 +154,7 @@ void Rank::ReceiveFromBus(BusPacket *busPacket)
 			bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + tCCD);
 		}
 		bankStates[busPacket->bank].lastCommand = WRITE_P;
-		bankStates[busPacket->bank].stateChangeCountdown = tCWL + TRANSACTION_SIZE/DRAM_BUS_WIDTH + tWR;
+		bankStates[busPacket->bank].stateChangeCountdown = tCWL + busPacket->burstLength + tWR;
 		bankStates[busPacket->bank].nextActivate = currentClockCycle + tCWL + busPacket->burstLength + tWR + tRP;
 		bankStates[busPacket->bank].nextRead = bankStates[busPacket->bank].nextActivate;
 		bankStates[busPacket->bank].nextWrite = bankStates[busPacket->bank].nextActivate;
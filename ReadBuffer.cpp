@@ -0,0 +1,159 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//ReadBuffer source file
+
+#include <algorithm>
+#include "ReadBuffer.h"
+
+using std::max;
+
+namespace BOBSim
+{
+
+ReadBuffer::ReadBuffer():
+	numSets(max(READ_BUFFER_SIZE / (TRANSACTION_SIZE * READ_BUFFER_ASSOCIATIVITY), 1u)),
+	lines(numSets * READ_BUFFER_ASSOCIATIVITY, 0),
+	lastUse(numSets * READ_BUFFER_ASSOCIATIVITY, 0),
+	useCounter(0),
+	lookups(0),
+	hits(0),
+	fills(0),
+	writeHits(0),
+	evictions(0)
+{}
+
+//Returns the way in set holding line, or -1
+int ReadBuffer::FindWay(uint64_t line, unsigned set)
+{
+	uint64_t *ways = &lines[set * READ_BUFFER_ASSOCIATIVITY];
+	for(unsigned w=0; w<READ_BUFFER_ASSOCIATIVITY; w++)
+	{
+		if(ways[w]==line+1) return w;
+	}
+	return -1;
+}
+
+//Looks for the line holding address and marks it as most recently used
+bool ReadBuffer::Lookup(uint64_t address)
+{
+	uint64_t line = address / TRANSACTION_SIZE;
+	unsigned set = line % numSets;
+
+	lookups++;
+	int way = FindWay(line, set);
+	if(way==-1) return false;
+
+	hits++;
+	lastUse[set * READ_BUFFER_ASSOCIATIVITY + way] = ++useCounter;
+	return true;
+}
+
+//Puts the line holding address in the buffer, replacing the least recently used way of its set - unless
+//  the line was written after the read that brought it back started
+void ReadBuffer::Fill(uint64_t address, uint64_t readStart)
+{
+	uint64_t line = address / TRANSACTION_SIZE;
+	unsigned set = line % numSets;
+	unsigned base = set * READ_BUFFER_ASSOCIATIVITY;
+
+	map<uint64_t, uint64_t>::iterator it = lastWrite.find(line);
+	if(it!=lastWrite.end() && it->second>=readStart)
+	{
+		return;
+	}
+
+	int way = FindWay(line, set);
+	if(way==-1)
+	{
+		//invalid ways have never been used, so they go first
+		way = 0;
+		for(unsigned w=1; w<READ_BUFFER_ASSOCIATIVITY; w++)
+		{
+			if(lastUse[base + w] < lastUse[base + way]) way = w;
+		}
+
+		if(lines[base + way]!=0) evictions++;
+		lines[base + way] = line + 1;
+		fills++;
+	}
+
+	lastUse[base + way] = ++useCounter;
+}
+
+//A write to address either updates the line (write-through) or drops it (write-invalidate).
+//  Either way the write still goes to DRAM.
+void ReadBuffer::Write(uint64_t address, uint64_t cycle)
+{
+	uint64_t line = address / TRANSACTION_SIZE;
+	unsigned set = line % numSets;
+	lastWrite[line] = cycle;
+
+	int way = FindWay(line, set);
+	if(way==-1) return;
+
+	writeHits++;
+	if(READ_BUFFER_WRITE_THROUGH)
+	{
+		lastUse[set * READ_BUFFER_ASSOCIATIVITY + way] = ++useCounter;
+	}
+	else
+	{
+		lines[set * READ_BUFFER_ASSOCIATIVITY + way] = 0;
+		lastUse[set * READ_BUFFER_ASSOCIATIVITY + way] = 0;
+	}
+}
+
+//The line holding address was changed somewhere the buffer can't see (e.g., by a logic op in a
+//  channel), so it has to go
+void ReadBuffer::Invalidate(uint64_t address, uint64_t cycle)
+{
+	uint64_t line = address / TRANSACTION_SIZE;
+	unsigned set = line % numSets;
+	lastWrite[line] = cycle;
+
+	int way = FindWay(line, set);
+	if(way==-1) return;
+
+	lines[set * READ_BUFFER_ASSOCIATIVITY + way] = 0;
+	lastUse[set * READ_BUFFER_ASSOCIATIVITY + way] = 0;
+}
+
+//Writes before cycle can't matter to any read still out
+void ReadBuffer::ForgetWritesBefore(uint64_t cycle)
+{
+	for(map<uint64_t, uint64_t>::iterator it=lastWrite.begin(); it!=lastWrite.end(); )
+	{
+		if(it->second<cycle) lastWrite.erase(it++);
+		else it++;
+	}
+}
+
+} // namespace BOBSim
@@ -0,0 +1,77 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef READBUFFER_H
+#define READBUFFER_H
+
+#include <vector>
+#include <map>
+#include "Globals.h"
+
+using std::vector;
+using std::map;
+namespace BOBSim
+{
+//Set-associative buffer of recently read lines on the main BOB controller
+class ReadBuffer
+{
+public:
+	//Functions
+	ReadBuffer();
+	bool Lookup(uint64_t address);
+	void Fill(uint64_t address, uint64_t readStart);
+	void Write(uint64_t address, uint64_t cycle);
+	void Invalidate(uint64_t address, uint64_t cycle);
+	void ForgetWritesBefore(uint64_t cycle);
+
+	//Fields
+	unsigned numSets;
+	//Line address + 1 held in each way (0 means invalid) - the ways of a set are next to each other
+	vector<uint64_t> lines;
+	//When each way was last used, for LRU replacement
+	vector<uint64_t> lastUse;
+	uint64_t useCounter;
+	//Cycle of the latest write to each line, so a read that was already out when the line was
+	//  written doesn't put the old data back
+	map<uint64_t, uint64_t> lastWrite;
+
+	//Bookkeeping
+	unsigned lookups;
+	unsigned hits;
+	unsigned fills;
+	unsigned writeHits;
+	unsigned evictions;
+
+private:
+	int FindWay(uint64_t line, unsigned set);
+};
+}
+
+#endif
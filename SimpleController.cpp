@@ -47,8 +47,15 @@ SimpleController::SimpleController(DRAMChannel *parent) :
 	numActBanksAverage(0),
 	numPreBanksAverage(0),
 	numRefBanksAverage(0),
-	RRQFull(0),
+	RRQFullReadStalls(0),
+	RRQFullWriteStalls(0),
+	returnQueueReserved(0),
+	writesCombined(0),
+	readsForwarded(0),
+	fillLines(0),
+	fillActivates(0),
 	waitingACTS(0),
+	prefetchesIssued(0),
 	idd2nCount(0),
 	rankBitWidth(log2(NUM_RANKS)),
 	bankBitWidth(log2(NUM_BANKS)),
@@ -100,6 +107,15 @@ SimpleController::SimpleController(DRAMChannel *parent) :
 	refreshEnergy = vector<uint64_t>(NUM_RANKS,0);
 	idd2nCount = vector<unsigned>(NUM_RANKS,0);
 
+	//init prefetcher
+	streamLastLine = vector<uint64_t>(PREFETCH_STREAMS,0);
+	streamStride = vector<int64_t>(PREFETCH_STREAMS,0);
+	streamConfidence = vector<unsigned>(PREFETCH_STREAMS,0);
+	streamNextPrefetch = vector<uint64_t>(PREFETCH_STREAMS,0);
+	streamLastUse = vector<uint64_t>(PREFETCH_STREAMS,0);
+	streamUseCounter = 0;
+	prefetchID = 0;
+
 
 	//init refresh counters
 	for(unsigned i=0; i<NUM_RANKS; i++)
@@ -329,7 +345,9 @@ void SimpleController::Update()
 	//If no refresh is being issued then do this block
 	if(!issuingRefresh)
 	{
-		for(unsigned i=0; i<commandQueue.size(); i++)
+		bool issued = false;
+
+		for(unsigned i=0; i<commandQueue.size() && !issued; i++)
 		{
 			//Checks to see if this particular request can be issued
 			if(IsIssuable(commandQueue[i]))
@@ -338,145 +356,22 @@ void SimpleController::Update()
 				if(i>0 && commandQueue[i]->transactionID == commandQueue[i-1]->transactionID)
 					continue;
 
-				//send to channel
-				(*CommandCallback)(commandQueue[i],0);
-
-				//update channel controllers bank state bookkeeping
-				unsigned rank = commandQueue[i]->rank;
-				unsigned bank = commandQueue[i]->bank;
-				BusPacket *writeData;
-
-				//
-				//Main block for determining what to do with each type of command
-				//
-				switch(commandQueue[i]->busPacketType)
-				{
-				case READ_P:
-					outstandingReads++;
-					waitingACTS--;
-					if(waitingACTS<0)
-					{
-						ERROR("#@)($J@)#(RJ");
-						exit(0);
-					}
-
-					//keep track of energy
-					burstEnergy[rank] += (IDD4R - IDD3N) * BL/2 * ((DRAM_BUS_WIDTH/2 * 8) / DEVICE_WIDTH);
-
-					bankStates[rank][bank].lastCommand = READ_P;
-					bankStates[rank][bank].stateChangeCountdown = (4*tCK>7.5)?tRTP:ceil(7.5/tCK); //4 clk or 7.5ns
-					bankStates[rank][bank].nextActivate = max(bankStates[rank][bank].nextActivate, currentClockCycle + tRTP + tRP);
-					bankStates[rank][bank].nextRefresh = currentClockCycle + tRTP + tRP;
-
-					for(unsigned r=0; r<NUM_RANKS; r++)
-					{
-						if(r==rank)
-						{
-							for(unsigned b=0; b<NUM_BANKS; b++)
-							{
-								bankStates[r][b].nextRead = max(bankStates[r][b].nextRead,
-								                                currentClockCycle + max(tCCD, TRANSACTION_SIZE/DRAM_BUS_WIDTH));
-								bankStates[r][b].nextWrite = max(bankStates[r][b].nextWrite,
-								                                 currentClockCycle + (tCL + TRANSACTION_SIZE/DRAM_BUS_WIDTH + tRTRS - tCWL));
-							}
-						}
-						else
-						{
-							for(unsigned b=0; b<NUM_BANKS; b++)
-							{
-								bankStates[r][b].nextRead = max(bankStates[r][b].nextRead,
-								                                currentClockCycle + TRANSACTION_SIZE/DRAM_BUS_WIDTH + tRTRS);
-								bankStates[r][b].nextWrite = max(bankStates[r][b].nextWrite,
-								                                 currentClockCycle + (tCL + TRANSACTION_SIZE/DRAM_BUS_WIDTH + tRTRS - tCWL));
-							}
-						}
-					}
-
-					//prevents read or write being issued while waiting for auto-precharge to close page
-					bankStates[rank][bank].nextRead = bankStates[rank][bank].nextActivate;
-					bankStates[rank][bank].nextWrite = bankStates[rank][bank].nextActivate;
-
-					break;
-				case WRITE_P:
-					waitingACTS--;
-					if(waitingACTS<0)
-					{
-						ERROR(")(JWE)(FJEWF");
-						exit(0);
-					}
-
-					//keep track of energy
-					burstEnergy[rank] += (IDD4W - IDD3N) * BL/2 * ((DRAM_BUS_WIDTH/2 * 8) / DEVICE_WIDTH);
-
-					writeData = new BusPacket(*commandQueue[i]);
-					writeData->busPacketType = WRITE_DATA;
-					writeBurstQueue.push_back(writeData);
-					writeBurstCountdown.push_back(tCWL);
-					if(DEBUG_CHANNEL) DEBUG("     !!! After Issuing WRITE_P, burstQueue is :"<<writeBurstQueue.size()<<" "<<writeBurstCountdown.size()<<" with head : "<<writeBurstCountdown[0]);
-
-					bankStates[rank][bank].lastCommand = WRITE_P;
-					bankStates[rank][bank].stateChangeCountdown = tCWL + TRANSACTION_SIZE/DRAM_BUS_WIDTH + tWR;
-					bankStates[rank][bank].nextActivate = currentClockCycle + tCWL + TRANSACTION_SIZE/DRAM_BUS_WIDTH + tWR + tRP;
-					bankStates[rank][bank].nextRefresh = currentClockCycle + tCWL + TRANSACTION_SIZE/DRAM_BUS_WIDTH + tWR + tRP;
-
-					for(unsigned r=0; r<NUM_RANKS; r++)
-					{
-						if(r==rank)
-						{
-							for(unsigned b=0; b<NUM_BANKS; b++)
-							{
-								bankStates[r][b].nextRead = max(bankStates[r][b].nextRead, currentClockCycle + tCWL + TRANSACTION_SIZE/DRAM_BUS_WIDTH + tWTR);
-								bankStates[r][b].nextWrite = max(bankStates[r][b].nextWrite, currentClockCycle+(uint64_t)max(tCCD, TRANSACTION_SIZE/DRAM_BUS_WIDTH));
-							}
-						}
-						else
-						{
-							for(unsigned b=0; b<NUM_BANKS; b++)
-							{
-								bankStates[r][b].nextRead = max(bankStates[r][b].nextRead, currentClockCycle + tCWL + TRANSACTION_SIZE/DRAM_BUS_WIDTH + tRTRS - tCL);
-								bankStates[r][b].nextWrite = max(bankStates[r][b].nextWrite, currentClockCycle + TRANSACTION_SIZE/DRAM_BUS_WIDTH + tRTRS);
-							}
-						}
-					}
-
-					//prevents read or write being issued while waiting for auto-precharge to close page
-					bankStates[rank][bank].nextRead = bankStates[rank][bank].nextActivate;
-					bankStates[rank][bank].nextWrite = bankStates[rank][bank].nextActivate;
-
-					break;
-				case ACTIVATE:
-					for(unsigned b=0; b<NUM_BANKS; b++)
-					{
-						if(b!=bank)
-						{
-							bankStates[rank][b].nextActivate = max(currentClockCycle + tRRD, bankStates[rank][b].nextActivate);
-						}
-					}
-
-					actpreEnergy[rank] += ((IDD0 * tRC) - ((IDD3N * tRAS) + (IDD2N * (tRC - tRAS)))) * ((DRAM_BUS_WIDTH/2 * 8) / DEVICE_WIDTH);
-
-					bankStates[rank][bank].lastCommand = ACTIVATE;
-					bankStates[rank][bank].currentBankState = ROW_ACTIVE;
-					bankStates[rank][bank].openRowAddress = commandQueue[i]->row;
-					bankStates[rank][bank].nextActivate = currentClockCycle + tRC;
-					bankStates[rank][bank].nextRead = max(currentClockCycle + tRCD, bankStates[rank][bank].nextRead);
-					bankStates[rank][bank].nextWrite = max(currentClockCycle + tRCD, bankStates[rank][bank].nextWrite);
-
-					//keep track of sliding window
-					tFAWWindow[rank].push_back(tFAW);
-
-					break;
-				default:
-					ERROR("Unexpected packet type" << *commandQueue[i]);
-					abort();
-
-
-				}
+				IssueCommand(commandQueue[i]);
 
 				//erase
 				commandQueue.erase(commandQueue.begin()+i);
 
-				break;
+				issued = true;
+			}
+		}
+
+		//prefetches only get the command bus when no demand request could use it - a READ_P
+		//  whose row is already open goes before opening another row
+		if(!issued && ENABLE_PREFETCHING)
+		{
+			if(!IssuePrefetch(true))
+			{
+				IssuePrefetch(false);
 			}
 		}
 	}
@@ -533,59 +428,207 @@ void SimpleController::Update()
 }
 
 
-bool SimpleController::IsIssuable(BusPacket *busPacket)
+//Sends a command to the command bus and updates the bank states it affects
+void SimpleController::IssueCommand(BusPacket *busPacket)
 {
+	//send to channel
+	(*CommandCallback)(busPacket,0);
+
+	//update channel controllers bank state bookkeeping
 	unsigned rank = busPacket->rank;
 	unsigned bank = busPacket->bank;
+	BusPacket *writeData;
 
-	//if((channel->readReturnQueue.size()+outstandingReads) * TRANSACTION_SIZE >= CHANNEL_RETURN_Q_MAX)
-	//if((channel->readReturnQueue.size()) * TRANSACTION_SIZE >= CHANNEL_RETURN_Q_MAX)
-	//	{
-	//RRQFull++;
-	//DEBUG("!!!!!!!!!"<<*busPacket)
-	//exit(0);
-	//return false;
-	//}
-
-
+	//
+	//Main block for determining what to do with each type of command
+	//
 	switch(busPacket->busPacketType)
 	{
 	case READ_P:
-		if(bankStates[rank][bank].currentBankState == ROW_ACTIVE &&
-		        bankStates[rank][bank].openRowAddress == busPacket->row &&
-		        currentClockCycle >= bankStates[rank][bank].nextRead &&
-		        (channel->readReturnQueue.size()+outstandingReads) * TRANSACTION_SIZE < CHANNEL_RETURN_Q_MAX)
+		//prefetches go to the prefetch buffer and were never counted as waiting requests
+		if(busPacket->isPrefetch)
 		{
-			return true;
+			prefetchesIssued++;
 		}
 		else
 		{
-
-			if((channel->readReturnQueue.size()+outstandingReads) * TRANSACTION_SIZE >= CHANNEL_RETURN_Q_MAX)
+			//logic op reads go back to the logic layer and never sit in the return queue
+			if(!busPacket->fromLogicOp)
+			{
+				outstandingReads++;
+				returnQueueReserved += TRANSACTION_SIZE;
+			}
+			waitingACTS--;
+			if(waitingACTS<0)
 			{
-				RRQFull++;
+				ERROR("#@)($J@)#(RJ");
+				exit(0);
 			}
+		}
 
-			return false;
+		//keep track of energy
+		burstEnergy[rank] += (IDD4R - IDD3N) * BL/2 * ((DRAM_BUS_WIDTH/2 * 8) / DEVICE_WIDTH);
+
+		bankStates[rank][bank].lastCommand = READ_P;
+		bankStates[rank][bank].stateChangeCountdown = (4*tCK>7.5)?tRTP:ceil(7.5/tCK); //4 clk or 7.5ns
+		bankStates[rank][bank].nextActivate = max(bankStates[rank][bank].nextActivate, currentClockCycle + tRTP + tRP);
+		bankStates[rank][bank].nextRefresh = currentClockCycle + tRTP + tRP;
+
+		for(unsigned r=0; r<NUM_RANKS; r++)
+		{
+			if(r==rank)
+			{
+				for(unsigned b=0; b<NUM_BANKS; b++)
+				{
+					bankStates[r][b].nextRead = max(bankStates[r][b].nextRead,
+					                                currentClockCycle + max(tCCD, TRANSACTION_SIZE/DRAM_BUS_WIDTH));
+					bankStates[r][b].nextWrite = max(bankStates[r][b].nextWrite,
+					                                 currentClockCycle + (tCL + TRANSACTION_SIZE/DRAM_BUS_WIDTH + tRTRS - tCWL));
+				}
+			}
+			else
+			{
+				for(unsigned b=0; b<NUM_BANKS; b++)
+				{
+					bankStates[r][b].nextRead = max(bankStates[r][b].nextRead,
+					                                currentClockCycle + TRANSACTION_SIZE/DRAM_BUS_WIDTH + tRTRS);
+					bankStates[r][b].nextWrite = max(bankStates[r][b].nextWrite,
+					                                 currentClockCycle + (tCL + TRANSACTION_SIZE/DRAM_BUS_WIDTH + tRTRS - tCWL));
+				}
+			}
 		}
 
+		//prevents read or write being issued while waiting for auto-precharge to close page
+		bankStates[rank][bank].nextRead = bankStates[rank][bank].nextActivate;
+		bankStates[rank][bank].nextWrite = bankStates[rank][bank].nextActivate;
+
 		break;
 	case WRITE_P:
+		waitingACTS--;
+		if(waitingACTS<0)
+		{
+			ERROR(")(JWE)(FJEWF");
+			exit(0);
+		}
+
+		//once the write is on the bus, nothing else can be combined with it
+		if(!busPacket->fromLogicOp)
+		{
+			map<uint64_t, BusPacket*>::iterator it = pendingWrites.find(busPacket->address >> cacheOffset);
+			if(it!=pendingWrites.end() && it->second==busPacket)
+			{
+				pendingWrites.erase(it);
+			}
+		}
+
+		//keep track of energy (row bursts from fills write several lines)
+		burstEnergy[rank] += (IDD4W - IDD3N) * BL/2 * ((DRAM_BUS_WIDTH/2 * 8) / DEVICE_WIDTH) * max(1u, busPacket->burstLength / (TRANSACTION_SIZE/DRAM_BUS_WIDTH));
+
+		writeData = new BusPacket(*busPacket);
+		writeData->busPacketType = WRITE_DATA;
+		writeBurstQueue.push_back(writeData);
+		writeBurstCountdown.push_back(tCWL);
+		if(DEBUG_CHANNEL) DEBUG("     !!! After Issuing WRITE_P, burstQueue is :"<<writeBurstQueue.size()<<" "<<writeBurstCountdown.size()<<" with head : "<<writeBurstCountdown[0]);
+
+		bankStates[rank][bank].lastCommand = WRITE_P;
+		bankStates[rank][bank].stateChangeCountdown = tCWL + busPacket->burstLength + tWR;
+		bankStates[rank][bank].nextActivate = currentClockCycle + tCWL + busPacket->burstLength + tWR + tRP;
+		bankStates[rank][bank].nextRefresh = currentClockCycle + tCWL + busPacket->burstLength + tWR + tRP;
+
+		for(unsigned r=0; r<NUM_RANKS; r++)
+		{
+			if(r==rank)
+			{
+				for(unsigned b=0; b<NUM_BANKS; b++)
+				{
+					bankStates[r][b].nextRead = max(bankStates[r][b].nextRead, currentClockCycle + tCWL + busPacket->burstLength + tWTR);
+					bankStates[r][b].nextWrite = max(bankStates[r][b].nextWrite, currentClockCycle+(uint64_t)max(tCCD, busPacket->burstLength));
+				}
+			}
+			else
+			{
+				for(unsigned b=0; b<NUM_BANKS; b++)
+				{
+					bankStates[r][b].nextRead = max(bankStates[r][b].nextRead, currentClockCycle + tCWL + busPacket->burstLength + tRTRS - tCL);
+					bankStates[r][b].nextWrite = max(bankStates[r][b].nextWrite, currentClockCycle + busPacket->burstLength + tRTRS);
+				}
+			}
+		}
+
+		//prevents read or write being issued while waiting for auto-precharge to close page
+		bankStates[rank][bank].nextRead = bankStates[rank][bank].nextActivate;
+		bankStates[rank][bank].nextWrite = bankStates[rank][bank].nextActivate;
+
+		break;
+	case ACTIVATE:
+		for(unsigned b=0; b<NUM_BANKS; b++)
+		{
+			if(b!=bank)
+			{
+				bankStates[rank][b].nextActivate = max(currentClockCycle + tRRD, bankStates[rank][b].nextActivate);
+			}
+		}
+
+		actpreEnergy[rank] += ((IDD0 * tRC) - ((IDD3N * tRAS) + (IDD2N * (tRC - tRAS)))) * ((DRAM_BUS_WIDTH/2 * 8) / DEVICE_WIDTH);
+
+		bankStates[rank][bank].lastCommand = ACTIVATE;
+		bankStates[rank][bank].currentBankState = ROW_ACTIVE;
+		bankStates[rank][bank].openRowAddress = busPacket->row;
+		bankStates[rank][bank].nextActivate = currentClockCycle + tRC;
+		bankStates[rank][bank].nextRead = max(currentClockCycle + tRCD, bankStates[rank][bank].nextRead);
+		bankStates[rank][bank].nextWrite = max(currentClockCycle + tRCD, bankStates[rank][bank].nextWrite);
+
+		//keep track of sliding window
+		tFAWWindow[rank].push_back(tFAW);
+
+		break;
+	default:
+		ERROR("Unexpected packet type" << *busPacket);
+		abort();
+
+
+	}
+}
+
+bool SimpleController::IsIssuable(BusPacket *busPacket)
+{
+	unsigned rank = busPacket->rank;
+	unsigned bank = busPacket->bank;
+
+	//a read needs room in the return queue for its data, which is reserved when it issues
+	bool returnQueueFull = returnQueueReserved + TRANSACTION_SIZE > CHANNEL_RETURN_Q_MAX;
+
+	switch(busPacket->busPacketType)
+	{
+	case READ_P:
 		if(bankStates[rank][bank].currentBankState == ROW_ACTIVE &&
 		        bankStates[rank][bank].openRowAddress == busPacket->row &&
-		        currentClockCycle >= bankStates[rank][bank].nextWrite &&
-		        (channel->readReturnQueue.size()+outstandingReads) * TRANSACTION_SIZE < CHANNEL_RETURN_Q_MAX)
+		        currentClockCycle >= bankStates[rank][bank].nextRead)
 		{
+			if(returnQueueFull && !busPacket->fromLogicOp && !busPacket->isPrefetch)
+			{
+				RRQFullReadStalls++;
+				return false;
+			}
 			return true;
 		}
-		else
+		else return false;
+
+		break;
+	case WRITE_P:
+		if(bankStates[rank][bank].currentBankState == ROW_ACTIVE &&
+		        bankStates[rank][bank].openRowAddress == busPacket->row &&
+		        currentClockCycle >= bankStates[rank][bank].nextWrite)
 		{
-			if((channel->readReturnQueue.size()+outstandingReads) * TRANSACTION_SIZE >= CHANNEL_RETURN_Q_MAX)
+			if(returnQueueFull && RRQ_FULL_BLOCKS_WRITES)
 			{
-				RRQFull++;
+				RRQFullWriteStalls++;
+				return false;
 			}
-			return false;
+			return true;
 		}
+		else return false;
+
 		break;
 	case ACTIVATE:
 		if(bankStates[rank][bank].currentBankState == IDLE &&
@@ -605,36 +648,90 @@ bool SimpleController::IsIssuable(BusPacket *busPacket)
 
 void SimpleController::AddTransaction(Transaction *trans)
 {
+	//a logic layer fill covering several lines goes out a row at a time
+	if(trans->transactionType==DATA_WRITE && trans->transactionSize>TRANSACTION_SIZE)
+	{
+		AddRowFill(trans);
+		return;
+	}
+
 	//map physical address to rank/bank/row/col
 	AddressMapping(trans->address,mappedRank,mappedBank,mappedRow,mappedCol);
 
+	//a logic write can go ahead of a queued write to its line, so that write's data can't be
+	//  forwarded or combined with anymore
+	if(trans->originatedFromLogicOp && trans->transactionType==DATA_WRITE)
+	{
+		pendingWrites.erase(trans->address >> cacheOffset);
+	}
+
 	if(GIVE_LOGIC_PRIORITY && trans->originatedFromLogicOp)
 	{
 		//if requests from logic ops have priority, put them at the front so they go first
 		if(DEBUG_LOGIC) DEBUG("  == Simple Controller received transaction from logic op : "<<*trans);
+		unsigned index = LogicInsertIndex(mappedRank,mappedBank,mappedRow,mappedCol);
 		switch(trans->transactionType)
 		{
 		case DATA_READ:
 			readCounter++;
 			//create column read bus packet and add it to command queue
-			commandQueue.push_front(new BusPacket(READ_P,trans->transactionID,mappedCol,mappedRow,mappedRank,mappedBank,trans->portID,trans->transactionSize/DRAM_BUS_WIDTH,trans->mappedChannel,trans->address,trans->originatedFromLogicOp));
+			commandQueue.insert(commandQueue.begin()+index, new BusPacket(READ_P,trans->transactionID,mappedCol,mappedRow,mappedRank,mappedBank,trans->portID,trans->transactionSize/DRAM_BUS_WIDTH,trans->mappedChannel,trans->address,trans->originatedFromLogicOp));
 			break;
 		case DATA_WRITE:
 			writeCounter++;
 			//create column write bus packet and add it to command queue
-			commandQueue.push_front(new BusPacket(WRITE_P,trans->transactionID,mappedCol,mappedRow,mappedRank,mappedBank,trans->portID,trans->transactionSize/DRAM_BUS_WIDTH,trans->mappedChannel,trans->address,trans->originatedFromLogicOp));
-			delete trans;
+			commandQueue.insert(commandQueue.begin()+index, new BusPacket(WRITE_P,trans->transactionID,mappedCol,mappedRow,mappedRank,mappedBank,trans->portID,trans->transactionSize/DRAM_BUS_WIDTH,trans->mappedChannel,trans->address,trans->originatedFromLogicOp));
 			break;
 		default:
 			ERROR("== ERROR - Adding wrong transaction to simple controller : "<<*trans);
 			abort();
 			break;
 		}
-		//since we're pushing front, add the ACT after so it ends up being first
-		commandQueue.push_front(new BusPacket(ACTIVATE, trans->transactionID,mappedCol,mappedRow,mappedRank,mappedBank,trans->portID,0,trans->mappedChannel,trans->address,trans->originatedFromLogicOp));
+		//add the ACT in the same spot so it ends up in front of the column command
+		commandQueue.insert(commandQueue.begin()+index, new BusPacket(ACTIVATE, trans->transactionID,mappedCol,mappedRow,mappedRank,mappedBank,trans->portID,0,trans->mappedChannel,trans->address,trans->originatedFromLogicOp));
+		if(trans->transactionType==DATA_WRITE)
+		{
+			delete trans;
+		}
 	}
 	else
 	{
+		//see if there is already a write to this cache line waiting in the queue
+		if(ENABLE_WRITE_COMBINING && !trans->originatedFromLogicOp)
+		{
+			map<uint64_t, BusPacket*>::iterator it = pendingWrites.find(trans->address >> cacheOffset);
+			if(it!=pendingWrites.end())
+			{
+				if(trans->transactionType==DATA_WRITE)
+				{
+					if(DEBUG_CHANNEL) DEBUG("     == Combining "<<*trans<<" with "<<*it->second);
+					writesCombined++;
+
+					//the new data just overwrites the queued write, so report it as issued and
+					//  committed now (its data goes out with the queued write's burst)
+					BusPacket *combinedWrite = new BusPacket(WRITE_P,trans->transactionID,mappedCol,mappedRow,mappedRank,mappedBank,trans->portID,0,trans->mappedChannel,trans->address,false);
+					(*channel->ReportCallback)(combinedWrite,0);
+					combinedWrite->busPacketType = WRITE_DATA;
+					(*channel->ReportCallback)(combinedWrite,0);
+					delete combinedWrite;
+					delete trans;
+					return;
+				}
+				else if(trans->transactionType==DATA_READ &&
+				        returnQueueReserved + TRANSACTION_SIZE <= CHANNEL_RETURN_Q_MAX)
+				{
+					if(DEBUG_CHANNEL) DEBUG("     == Forwarding "<<*it->second<<" to "<<*trans);
+					readsForwarded++;
+					readCounter++;
+
+					//the data comes out of the work queue, so it goes straight to the return queue
+					returnQueueReserved += TRANSACTION_SIZE;
+					channel->ReturnReadData(new BusPacket(READ_DATA,trans->transactionID,mappedCol,mappedRow,mappedRank,mappedBank,trans->portID,0,trans->mappedChannel,trans->address,false));
+					return;
+				}
+			}
+		}
+
 		//create the row activate bus packet and add it to command queue
 		commandQueue.push_back(new BusPacket(ACTIVATE, trans->transactionID,mappedCol,mappedRow,mappedRank,mappedBank,trans->portID,0,trans->mappedChannel,trans->address,trans->originatedFromLogicOp));
 
@@ -649,6 +746,10 @@ void SimpleController::AddTransaction(Transaction *trans)
 			writeCounter++;
 			//create column write bus packet and add it to command queue
 			commandQueue.push_back(new BusPacket(WRITE_P,trans->transactionID,mappedCol,mappedRow,mappedRank,mappedBank,trans->portID,trans->transactionSize/DRAM_BUS_WIDTH,trans->mappedChannel,trans->address,trans->originatedFromLogicOp));
+			if(ENABLE_WRITE_COMBINING && !trans->originatedFromLogicOp)
+			{
+				pendingWrites[trans->address >> cacheOffset] = commandQueue.back();
+			}
 			delete trans;
 			break;
 		default:
@@ -661,7 +762,268 @@ void SimpleController::AddTransaction(Transaction *trans)
 	waitingACTS++;
 }
 
-void SimpleController::AddressMapping(uint64_t physicalAddress, unsigned &rank, unsigned &bank, unsigned &row, unsigned &col)
+//Logic requests go to the front of the queue, but never ahead of something already queued for the
+//  same line (including a fill burst covering it) - e.g., an atomic's write-back stays ahead of
+//  the next atomic to that line
+unsigned SimpleController::LogicInsertIndex(unsigned rank, unsigned bank, unsigned row, unsigned col)
+{
+	unsigned lineBurst = TRANSACTION_SIZE/DRAM_BUS_WIDTH;
+	unsigned lineCols = 1<<(cacheOffset-busOffsetBitWidth);
+	for(unsigned i=commandQueue.size(); i>0; i--)
+	{
+		BusPacket *queued = commandQueue[i-1];
+		if(queued->rank==rank && queued->bank==bank && queued->row==row &&
+		        (queued->column==col ||
+		         (col>queued->column && col<queued->column + queued->burstLength/lineBurst*lineCols)))
+		{
+			return i;
+		}
+	}
+	return 0;
+}
+
+//Address of the i-th line after start in this channel's column space - the column goes up
+//  by one line each step (carrying into the fields above it) while the channel, rank and
+//  bank bits below it stay put
+uint64_t SimpleController::ChannelLine(uint64_t start, uint64_t i)
+{
+	unsigned cacheBits = log2(CACHE_LINE_SIZE);
+	unsigned channelBits = log2(NUM_CHANNELS);
+	unsigned rankBits = log2(NUM_RANKS);
+	unsigned bankBits = log2(NUM_BANKS);
+	unsigned rowBits = log2_64(NUM_ROWS);
+	//column bits above the ones a line covers
+	unsigned colBits = log2(NUM_COLS) - (cacheBits - log2(BUS_ALIGNMENT_SIZE));
+	unsigned colOffset;
+
+	switch(mappingScheme)
+	{
+	case BK_CLH_RW_RK_CH_CLL_BY://bank:col_high:row:rank:chan:col_low:by
+		colOffset = cacheBits + channelBits + rankBits + rowBits;
+		break;
+	case CLH_RW_RK_BK_CH_CLL_BY://col_high:row:rank:bank:chan:col_low:byte
+		colOffset = cacheBits + channelBits + bankBits + rankBits + rowBits;
+		break;
+	case RK_BK_RW_CLH_CH_CLL_BY://rank:bank:row:col_high:chan:col_low:by
+	case RW_BK_RK_CLH_CH_CLL_BY://row:bank:rank:col_high:chan:col_low:byte
+		colOffset = cacheBits + channelBits;
+		break;
+	case RW_CLH_BK_RK_CH_CLL_BY://row:col_high:bank:rank:chan:col_low:byte
+		colOffset = cacheBits + channelBits + rankBits + bankBits;
+		break;
+	case RW_BK_RK_CH_CL_BY://row:bank:rank:chan:col:byte
+	case RW_CH_BK_RK_CL_BY://row:chan:bank:rank:col:byte
+	case CH_RW_BK_RK_CL_BY://chan:row:bank:rank:col:byte
+		colOffset = cacheBits;
+		break;
+	default:
+		ERROR("== ERROR - Unknown address mapping???");
+		exit(1);
+		break;
+	}
+
+	uint64_t column = ((start >> colOffset) & (((uint64_t)1<<colBits)-1)) + i;
+	uint64_t above = (start >> (colOffset + colBits)) + (column >> colBits);
+	uint64_t below = start & (((uint64_t)1<<colOffset)-1);
+	return (above << (colOffset + colBits)) | ((column & (((uint64_t)1<<colBits)-1)) << colOffset) | below;
+}
+
+//Splits a fill of several lines into an ACTIVATE and one long write burst per run of
+//  neighboring columns in a row, so each row is opened once and its column writes stream
+//  back to back
+void SimpleController::AddRowFill(Transaction *trans)
+{
+	unsigned numLines = trans->transactionSize / TRANSACTION_SIZE;
+	unsigned lineBurst = TRANSACTION_SIZE/DRAM_BUS_WIDTH;
+	unsigned lineCols = 1<<(cacheOffset-busOffsetBitWidth);
+	vector<BusPacket*> fill;
+	unsigned index = 0;
+
+	for(unsigned i=0; i<numLines; i++)
+	{
+		uint64_t address = ChannelLine(trans->address, i);
+		AddressMapping(address,mappedRank,mappedBank,mappedRow,mappedCol);
+		pendingWrites.erase(address >> cacheOffset);
+		writeCounter++;
+		fillLines++;
+		if(GIVE_LOGIC_PRIORITY)
+		{
+			index = max(index, LogicInsertIndex(mappedRank,mappedBank,mappedRow,mappedCol));
+		}
+
+		//picks up right where a burst to the same row ends - just make the burst longer
+		bool merged = false;
+		for(unsigned j=1; j<fill.size() && !merged; j+=2)
+		{
+			BusPacket *burst = fill[j];
+			if(burst->rank==mappedRank && burst->bank==mappedBank && burst->row==mappedRow &&
+			        burst->column + burst->burstLength/lineBurst*lineCols == mappedCol)
+			{
+				burst->burstLength += lineBurst;
+				merged = true;
+			}
+		}
+		if(merged) continue;
+
+		//each burst gets its own ID so rows in different banks can go in parallel
+		unsigned id = i==0 ? trans->transactionID : NewTransactionID();
+		fill.push_back(new BusPacket(ACTIVATE,id,mappedCol,mappedRow,mappedRank,mappedBank,trans->portID,0,trans->mappedChannel,address,true));
+		fill.push_back(new BusPacket(WRITE_P,id,mappedCol,mappedRow,mappedRank,mappedBank,trans->portID,lineBurst,trans->mappedChannel,address,true));
+		fillActivates++;
+		waitingACTS++;
+	}
+
+	if(DEBUG_LOGIC) DEBUG("  == Simple Controller split fill "<<*trans<<" ("<<numLines<<" lines) into "<<fill.size()/2<<" row bursts");
+
+	if(GIVE_LOGIC_PRIORITY)
+	{
+		//ahead of everything but requests already queued for the fill's lines
+		commandQueue.insert(commandQueue.begin()+index, fill.begin(), fill.end());
+	}
+	else
+	{
+		commandQueue.insert(commandQueue.end(), fill.begin(), fill.end());
+	}
+	delete trans;
+}
+
+//Follows the stream a demand read belongs to and queues prefetches ahead of it once
+//  the same stride has been seen PREFETCH_CONFIDENCE times in a row
+void SimpleController::TrainPrefetcher(uint64_t address)
+{
+	uint64_t line = address >> cacheOffset;
+
+	//find the stream this read continues
+	unsigned s;
+	for(s=0; s<PREFETCH_STREAMS; s++)
+	{
+		if(streamLastUse[s]==0) continue;
+		int64_t stride = (int64_t)(line - streamLastLine[s]);
+		if(stride!=0 && stride>=-(int64_t)PREFETCH_MAX_STRIDE && stride<=(int64_t)PREFETCH_MAX_STRIDE) break;
+	}
+
+	//start a new stream in place of the least recently used one
+	if(s==PREFETCH_STREAMS)
+	{
+		s = 0;
+		for(unsigned i=1; i<PREFETCH_STREAMS; i++)
+		{
+			if(streamLastUse[i]<streamLastUse[s]) s = i;
+		}
+		streamLastLine[s] = line;
+		streamStride[s] = 0;
+		streamConfidence[s] = 0;
+		streamLastUse[s] = ++streamUseCounter;
+		return;
+	}
+
+	int64_t stride = (int64_t)(line - streamLastLine[s]);
+	if(stride==streamStride[s])
+	{
+		streamConfidence[s]++;
+	}
+	else
+	{
+		streamStride[s] = stride;
+		streamConfidence[s] = 1;
+		streamNextPrefetch[s] = line;
+	}
+	streamLastLine[s] = line;
+	streamLastUse[s] = ++streamUseCounter;
+
+	if(streamConfidence[s]<PREFETCH_CONFIDENCE) return;
+
+	//keep PREFETCH_DEGREE lines ahead of the stream
+	uint64_t next = streamNextPrefetch[s];
+	if((int64_t)(next - line) / stride <= 0) next = line + stride;
+	while((int64_t)(next - line) / stride <= (int64_t)PREFETCH_DEGREE &&
+	        prefetchQueue.size() < 2*PREFETCH_QUEUE_MAX)
+	{
+		QueuePrefetch(next);
+		next += stride;
+	}
+	streamNextPrefetch[s] = next;
+}
+
+//Queues the ACTIVATE and READ_P to prefetch line unless the channel already has it
+void SimpleController::QueuePrefetch(uint64_t line)
+{
+	if(channel->PrefetchPresent(line) ||
+	        pendingWrites.find(line)!=pendingWrites.end())
+	{
+		return;
+	}
+
+	uint64_t address = line << cacheOffset;
+	AddressMapping(address,mappedRank,mappedBank,mappedRow,mappedCol);
+
+	BusPacket *activate = new BusPacket(ACTIVATE,prefetchID,mappedCol,mappedRow,mappedRank,mappedBank,0,0,channel->channelID,address,false);
+	BusPacket *read = new BusPacket(READ_P,prefetchID,mappedCol,mappedRow,mappedRank,mappedBank,0,TRANSACTION_SIZE/DRAM_BUS_WIDTH,channel->channelID,address,false);
+	activate->isPrefetch = true;
+	read->isPrefetch = true;
+	prefetchQueue.push_back(activate);
+	prefetchQueue.push_back(read);
+	prefetchID++;
+
+	channel->prefetchesInFlight.push_back(line);
+}
+
+//Removes the prefetch of line if its ACTIVATE hasn't gone out yet, so a demand read for
+//  the line doesn't wait behind it.  Returns false if there was nothing to remove.
+bool SimpleController::CancelPrefetch(uint64_t line)
+{
+	for(unsigned i=0; i<prefetchQueue.size(); i++)
+	{
+		if(prefetchQueue[i]->busPacketType==ACTIVATE &&
+		        (prefetchQueue[i]->address >> cacheOffset)==line)
+		{
+			//the READ_P is always right behind its ACTIVATE
+			delete prefetchQueue[i];
+			delete prefetchQueue[i+1];
+			prefetchQueue.erase(prefetchQueue.begin()+i, prefetchQueue.begin()+i+2);
+			return true;
+		}
+	}
+	return false;
+}
+
+//Issues one prefetch command - with readsOnly, a READ_P whose ACTIVATE has already gone out,
+//  otherwise an ACTIVATE to a bank that no demand request is waiting on
+bool SimpleController::IssuePrefetch(bool readsOnly)
+{
+	for(unsigned i=0; i<prefetchQueue.size(); i++)
+	{
+		BusPacket *busPacket = prefetchQueue[i];
+		if(readsOnly)
+		{
+			if(busPacket->busPacketType!=READ_P ||
+			        (i>0 && prefetchQueue[i-1]->transactionID==busPacket->transactionID))
+				continue;
+		}
+		else
+		{
+			if(busPacket->busPacketType!=ACTIVATE) continue;
+
+			bool bankWanted = false;
+			for(unsigned j=0; j<commandQueue.size() && !bankWanted; j++)
+			{
+				bankWanted = commandQueue[j]->rank==busPacket->rank && commandQueue[j]->bank==busPacket->bank;
+			}
+			if(bankWanted) continue;
+		}
+
+		if(IsIssuable(busPacket))
+		{
+			IssueCommand(busPacket);
+			prefetchQueue.erase(prefetchQueue.begin()+i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void SimpleController::AddressMapping(uint64_t physicalAddress, unsigned &, unsigned &, unsigned &, unsigned &)
 {
 	uint64_t tempA, tempB;
 
@@ -38,6 +38,7 @@
 #include "Transaction.h"
 #include "BankState.h"
 #include <deque>
+#include <map>
 
 using namespace std;
 
@@ -53,6 +54,8 @@ public:
 	bool IsIssuable(BusPacket *busPacket);
 	void Update();
 	void AddTransaction(Transaction *trans);
+	void TrainPrefetcher(uint64_t address);
+	bool CancelPrefetch(uint64_t line);
 	void RegisterCallback(Callback<DRAMChannel, void, BusPacket*, unsigned> *cmdCB,
 	                      Callback<DRAMChannel, void, BusPacket*, unsigned> *dataCB);
 
@@ -68,6 +71,9 @@ public:
 	//Work queue for pending requests (DRAM specific commands go here)
 	deque<BusPacket*> commandQueue;
 
+	//WRITE_P packets still waiting in the work queue, indexed by cache line
+	map<uint64_t, BusPacket*> pendingWrites;
+
 	//Bank states for all banks in this channel
 	BankState** bankStates;
 
@@ -85,10 +91,27 @@ public:
 	unsigned refreshCounter;
 	unsigned readCounter;
 	unsigned writeCounter;
-	unsigned RRQFull;
 	unsigned outstandingReads;
+
+	//Return queue space (in bytes) held by reads from the time they issue until
+	//  their response leaves on the link bus
+	unsigned returnQueueReserved;
+	//Number of cycles a READ_P or WRITE_P was ready to go but held back by a full return queue
+	unsigned RRQFullReadStalls;
+	unsigned RRQFullWriteStalls;
+
+	//Writes merged into a queued write and reads answered from a queued write
+	unsigned writesCombined;
+	unsigned readsForwarded;
+	//Lines written by logic layer fills and the ACTIVATEs they needed
+	unsigned fillLines;
+	unsigned fillActivates;
 	int waitingACTS;
 
+	//Prefetch commands waiting to issue (an ACTIVATE followed by its READ_P)
+	deque<BusPacket*> prefetchQueue;
+	unsigned prefetchesIssued;
+
 	//Power fields
 	vector<uint64_t> backgroundEnergy;
 	vector<uint64_t> burstEnergy;
@@ -96,9 +119,16 @@ public:
 	vector<uint64_t> refreshEnergy;
 
 	vector<unsigned> idd2nCount;
+
+	static uint64_t ChannelLine(uint64_t start, uint64_t i);
 private:
 	//Functions
 	void AddressMapping(uint64_t physicalAddress, unsigned &rank, unsigned &bank, unsigned &row, unsigned &col);
+	void IssueCommand(BusPacket *busPacket);
+	void AddRowFill(Transaction *trans);
+	unsigned LogicInsertIndex(unsigned rank, unsigned bank, unsigned row, unsigned col);
+	bool IssuePrefetch(bool readsOnly);
+	void QueuePrefetch(uint64_t line);
 
 	//Fields
 	DRAMChannel *channel;
@@ -116,6 +146,18 @@ private:
 	unsigned channelBitWidth;
 	unsigned cacheOffset;
 
+	//Stream table for the prefetcher - last line read, stride between the last two reads,
+	//  number of times in a row that stride was seen and the next line to prefetch
+	vector<uint64_t> streamLastLine;
+	vector<int64_t> streamStride;
+	vector<unsigned> streamConfidence;
+	vector<uint64_t> streamNextPrefetch;
+	//When each stream was last used (0 means the entry is empty)
+	vector<uint64_t> streamLastUse;
+	uint64_t streamUseCounter;
+	//IDs given to prefetch commands so a READ_P can find its ACTIVATE
+	unsigned prefetchID;
+
 	Callback<DRAMChannel, void, BusPacket*, unsigned> *CommandCallback;
 	Callback<DRAMChannel, void, BusPacket*, unsigned> *DataCallback;
 };
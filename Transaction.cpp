@@ -40,6 +40,7 @@ Transaction::Transaction(TransactionType transType, unsigned size, uint64_t addr
 	address(addr),
 	mappedChannel(0),
 	transactionSize(size),
+	compressedSize(0),
 	cyclesReqPort(0),
 	cyclesRspPort(0),
 	cyclesReqLink(0),
@@ -59,6 +60,12 @@ Transaction::Transaction(TransactionType transType, unsigned size, uint64_t addr
 	transactionID = globalID++;
 }
 
+//Hands out an ID for commands which don't have a transaction of their own
+unsigned NewTransactionID()
+{
+	return globalID++;
+}
+
 ostream& operator<<(ostream &out, const Transaction &t)
 {
 	if(t.transactionType == DATA_READ)
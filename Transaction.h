@@ -67,6 +67,8 @@ public:
 	unsigned mappedChannel;
 	//Size of data
 	unsigned transactionSize;
+	//Size of data after link compression (0 until known - may be set from a trace)
+	unsigned compressedSize;
 	//Unique identifier 
 	unsigned transactionID;
 	//Port ID used to send request
@@ -97,6 +99,7 @@ public:
 };
 
 ostream& operator<<(ostream &out, const Transaction &t);
+unsigned NewTransactionID();
 }
 
 #endif